@@ -0,0 +1,435 @@
+#pragma once
+
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// For std::size_t
+#include <cstddef>
+
+// For std::strcmp, std::strstr, std::strchr, std::strrchr
+#include <cstring>
+
+// For std::strtoull, std::strtod
+#include <cstdlib>
+
+// For std::chrono::steady_clock
+#include <chrono>
+
+// For std::string
+#include <string>
+
+// For std::vector
+#include <vector>
+
+// For std::cout, std::cerr
+#include <iostream>
+
+// For std::setw
+#include <iomanip>
+
+// For std::numeric_limits
+#include <limits>
+
+// For std::find_if
+#include <algorithm>
+
+// For std::atomic_signal_fence
+#include <atomic>
+
+// For std::unique_ptr
+#include <memory>
+
+// For std::isnan
+#include <cmath>
+
+// For std::ifstream, std::ofstream
+#include <fstream>
+
+// For std::pair
+#include <utility>
+
+// For perf_counters
+#include "perf_counters.h"
+
+// For write_benchmark_baseline, read_benchmark_baseline
+#include "benchmark_baseline.h"
+
+
+// A minimal, self-contained benchmark harness.
+//
+// Each case is timed over several repetitions and the fastest is kept,
+// as it is the one least disturbed by the rest of the system.
+
+// Keeps the compiler from discarding a value that is never used
+template<typename Type>
+inline void benchmark_keep(const Type & value)
+{
+#if defined(__GNUC__)
+	asm volatile("" : : "r,m"(value) : "memory");
+#else
+	static volatile const Type * volatile sink;
+	sink = &value;
+#endif
+}
+
+// Makes the compiler assume any memory may have changed,
+// so results computed from it can't be hoisted out of a loop
+inline void benchmark_clobber()
+{
+#if defined(__GNUC__)
+	asm volatile("" : : : "memory");
+#else
+	std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+struct benchmark_options
+{
+	const char * filter = nullptr;
+	std::size_t repetitions = 5;
+	std::size_t maximum_capacity = std::numeric_limits<std::size_t>::max();
+	const char * cpus = nullptr;
+	const char * input = nullptr;
+	bool csv = false;
+	bool counters = false;
+
+	// Baseline files to write the results to, or compare them against
+	const char * write_baseline = nullptr;
+	const char * compare_baseline = nullptr;
+
+	// The fraction a case may slow down by before it counts as a regression,
+	// and overrides for the cases whose names contain a given text
+	double tolerance = 0.10;
+	std::vector<std::pair<std::string, double>> tolerances;
+};
+
+struct benchmark_result
+{
+	std::string name;
+	std::size_t operations;
+	double nanoseconds_per_operation;
+
+	// Per operation, NaN when not collected
+	perf_counter_values counters {};
+};
+
+class benchmark_runner
+{
+private:
+	benchmark_options options;
+	std::vector<benchmark_result> results;
+	std::unique_ptr<perf_counters> counters;
+
+public:
+	explicit benchmark_runner(const benchmark_options & options) :
+		options { options }
+	{
+		if (this->options.counters)
+		{
+			this->counters = std::make_unique<perf_counters>();
+
+			if (!this->counters->available())
+				std::cerr << "Hardware counters are unavailable, only times will be reported\n";
+		}
+	}
+
+	const benchmark_options & settings() const
+	{
+		return this->options;
+	}
+
+	const std::vector<benchmark_result> & all_results() const
+	{
+		return this->results;
+	}
+
+	bool selected(const std::string & name) const
+	{
+		return (this->options.filter == nullptr) || (std::strstr(name.c_str(), this->options.filter) != nullptr);
+	}
+
+	// Runs body, which must perform exactly operations operations,
+	// once per repetition with setup run untimed beforehand.
+	template<typename Setup, typename Body>
+	void run(const std::string & name, std::size_t operations, Setup setup, Body body)
+	{
+		if (!this->selected(name))
+			return;
+
+		double best = std::numeric_limits<double>::max();
+		perf_counter_values best_counters;
+
+		for (std::size_t repetition = 0; repetition < this->options.repetitions; ++repetition)
+		{
+			setup();
+
+			if (this->counters)
+				this->counters->start();
+
+			const auto start = std::chrono::steady_clock::now();
+			body();
+			const auto end = std::chrono::steady_clock::now();
+
+			const perf_counter_values values = this->counters ? this->counters->stop() : perf_counter_values();
+			const double nanoseconds = std::chrono::duration<double, std::nano>(end - start).count();
+
+			// The counters are kept from the same repetition as the time
+			if (nanoseconds < best)
+			{
+				best = nanoseconds;
+				best_counters = values;
+			}
+		}
+
+		benchmark_result result { name, operations, (best / static_cast<double>(operations)) };
+
+		for (double & value : best_counters.values)
+			value /= static_cast<double>(operations);
+
+		result.counters = best_counters;
+
+		this->record(result);
+	}
+
+	template<typename Body>
+	void run(const std::string & name, std::size_t operations, Body body)
+	{
+		this->run(name, operations, []() {}, body);
+	}
+
+	// Reports a result that was measured by the caller
+	void record(const benchmark_result & result)
+	{
+		const perf_counter_values & counters = result.counters;
+		const double instructions_per_cycle = (counters[perf_counter::instructions] / counters[perf_counter::cycles]);
+
+		if (this->options.csv)
+		{
+			if (this->results.empty())
+			{
+				std::cout << "name,operations,ns_per_op";
+
+				if (this->options.counters)
+					std::cout << ",cycles_per_op,instructions_per_op,ipc,branch_misses_per_op,l1d_misses_per_op,llc_misses_per_op";
+
+				std::cout << '\n';
+			}
+
+			std::cout << result.name << ',' << result.operations << ',' << result.nanoseconds_per_operation;
+
+			if (this->options.counters)
+			{
+				std::cout << ',' << counters[perf_counter::cycles] << ',' << counters[perf_counter::instructions] << ',' << instructions_per_cycle;
+				std::cout << ',' << counters[perf_counter::branch_misses] << ',' << counters[perf_counter::l1d_misses] << ',' << counters[perf_counter::llc_misses];
+			}
+
+			std::cout << '\n';
+		}
+		else
+		{
+			if (this->options.counters && this->results.empty())
+			{
+				std::cout << std::left << std::setw(56) << "name" << std::right << std::setw(18) << "time";
+				std::cout << std::setw(10) << "cycles" << std::setw(10) << "instrs" << std::setw(8) << "ipc";
+				std::cout << std::setw(10) << "br-miss" << std::setw(10) << "l1d-miss" << std::setw(10) << "llc-miss" << '\n';
+			}
+
+			std::cout << std::left << std::setw(56) << result.name;
+			std::cout << std::right << std::setw(12) << std::fixed << std::setprecision(3) << result.nanoseconds_per_operation << " ns/op";
+
+			if (this->options.counters)
+			{
+				write_counter(counters[perf_counter::cycles], 10);
+				write_counter(counters[perf_counter::instructions], 10);
+				write_counter(instructions_per_cycle, 8);
+				write_counter(counters[perf_counter::branch_misses], 10);
+				write_counter(counters[perf_counter::l1d_misses], 10);
+				write_counter(counters[perf_counter::llc_misses], 10);
+			}
+
+			std::cout << '\n';
+		}
+
+		std::cout.flush();
+		this->results.push_back(result);
+	}
+
+	// Writes and compares baselines, as requested by the options.
+	// Returns the program's exit status: non-zero if any case regressed,
+	// if a selected baseline case wasn't run, or if nothing was compared.
+	int finish() const
+	{
+		if (this->options.write_baseline != nullptr)
+		{
+			std::ofstream stream(this->options.write_baseline);
+			write_benchmark_baseline(stream, this->results);
+
+			if (!stream)
+			{
+				std::cerr << "Couldn't write the baseline to " << this->options.write_baseline << '\n';
+				return 1;
+			}
+		}
+
+		if (this->options.compare_baseline != nullptr)
+			return this->compare(this->options.compare_baseline);
+
+		return 0;
+	}
+
+private:
+	double tolerance_for(const std::string & name) const
+	{
+		// The longest matching override is the most specific
+		double tolerance = this->options.tolerance;
+		std::size_t longest = 0;
+
+		for (const auto & entry : this->options.tolerances)
+			if ((entry.first.size() >= longest) && (name.find(entry.first) != std::string::npos))
+			{
+				tolerance = entry.second;
+				longest = entry.first.size();
+			}
+
+		return tolerance;
+	}
+
+	int compare(const char * path) const
+	{
+		std::ifstream stream(path);
+		std::vector<baseline_entry> baseline;
+
+		if (!read_benchmark_baseline(stream, baseline))
+		{
+			std::cerr << "Couldn't read a baseline from " << path << '\n';
+			return 1;
+		}
+
+		std::size_t regressions = 0;
+		std::size_t compared = 0;
+
+		std::cout << '\n' << std::left << std::setw(56) << "compared to baseline" << std::right;
+		std::cout << std::setw(12) << "baseline" << std::setw(12) << "current" << std::setw(10) << "change" << std::setw(10) << "limit" << '\n';
+
+		for (const benchmark_result & result : this->results)
+		{
+			const auto match = std::find_if(baseline.begin(), baseline.end(), [&result](const baseline_entry & entry) { return (entry.name == result.name); });
+
+			if ((match == baseline.end()) || !(match->nanoseconds_per_operation > 0))
+				continue;
+
+			const double change = ((result.nanoseconds_per_operation / match->nanoseconds_per_operation) - 1.0);
+			const double tolerance = this->tolerance_for(result.name);
+			const bool regressed = (change > tolerance);
+
+			++compared;
+
+			if (regressed)
+				++regressions;
+
+			std::cout << std::left << std::setw(56) << result.name << std::right << std::fixed << std::setprecision(3);
+			std::cout << std::setw(12) << match->nanoseconds_per_operation << std::setw(12) << result.nanoseconds_per_operation;
+			std::cout << std::setprecision(1) << std::showpos << std::setw(9) << (change * 100.0) << '%' << std::noshowpos;
+			std::cout << std::setw(9) << (tolerance * 100.0) << '%' << (regressed ? "  REGRESSED" : "") << '\n';
+		}
+
+		// A baseline case the filter selected but this run never produced was renamed or removed
+		std::size_t missing = 0;
+
+		for (const baseline_entry & entry : baseline)
+		{
+			if (!this->selected(entry.name))
+				continue;
+
+			const auto match = std::find_if(this->results.begin(), this->results.end(), [&entry](const benchmark_result & result) { return (result.name == entry.name); });
+
+			if (match != this->results.end())
+				continue;
+
+			++missing;
+			std::cout << std::left << std::setw(56) << entry.name << std::right << "  NOT RUN\n";
+		}
+
+		std::cout << compared << " cases compared, " << regressions << " regressed, " << missing << " not run\n";
+
+		// Comparing nothing would pass whatever the filter or baseline
+		if (compared == 0)
+		{
+			std::cerr << "No case was compared against the baseline in " << path << '\n';
+			return 1;
+		}
+
+		return ((regressions > 0) || (missing > 0)) ? 1 : 0;
+	}
+
+	static void write_counter(double value, int width)
+	{
+		if (std::isnan(value))
+			std::cout << std::setw(width) << '-';
+		else
+			std::cout << std::setw(width) << std::setprecision(2) << value;
+	}
+};
+
+// Parses the options shared by every benchmark program.
+// Returns false and prints usage if the arguments are malformed.
+inline bool parse_benchmark_options(int argc, char ** argv, benchmark_options & options)
+{
+	for (int index = 1; index < argc; ++index)
+	{
+		const char * argument = argv[index];
+		const bool has_value = ((index + 1) < argc);
+
+		if ((std::strcmp(argument, "--filter") == 0) && has_value)
+			options.filter = argv[++index];
+		else if ((std::strcmp(argument, "--repetitions") == 0) && has_value)
+			options.repetitions = static_cast<std::size_t>(std::strtoull(argv[++index], nullptr, 10));
+		else if ((std::strcmp(argument, "--max-capacity") == 0) && has_value)
+			options.maximum_capacity = static_cast<std::size_t>(std::strtoull(argv[++index], nullptr, 10));
+		else if ((std::strcmp(argument, "--cpus") == 0) && has_value)
+			options.cpus = argv[++index];
+		else if ((std::strcmp(argument, "--input") == 0) && has_value)
+			options.input = argv[++index];
+		else if (std::strcmp(argument, "--csv") == 0)
+			options.csv = true;
+		else if (std::strcmp(argument, "--counters") == 0)
+			options.counters = true;
+		else if ((std::strcmp(argument, "--write-baseline") == 0) && has_value)
+			options.write_baseline = argv[++index];
+		else if ((std::strcmp(argument, "--compare-baseline") == 0) && has_value)
+			options.compare_baseline = argv[++index];
+		else if ((std::strcmp(argument, "--tolerance") == 0) && has_value)
+			options.tolerance = std::strtod(argv[++index], nullptr);
+		else if ((std::strcmp(argument, "--tolerance-for") == 0) && has_value && (std::strchr(argv[index + 1], '=') != nullptr))
+		{
+			// Given as text=fraction
+			const char * value = argv[++index];
+			const char * separator = std::strrchr(value, '=');
+			options.tolerances.emplace_back(std::string(value, separator), std::strtod(separator + 1, nullptr));
+		}
+		else
+		{
+			std::cerr << "usage: " << argv[0] << " [--filter text] [--repetitions n] [--max-capacity n] [--cpus list] [--input path] [--csv] [--counters]";
+			std::cerr << " [--write-baseline path] [--compare-baseline path] [--tolerance fraction] [--tolerance-for text=fraction]\n";
+			return false;
+		}
+	}
+
+	if (options.repetitions == 0)
+		options.repetitions = 1;
+
+	return true;
+}
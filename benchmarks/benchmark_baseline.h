@@ -0,0 +1,169 @@
+#pragma once
+
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// For std::size_t
+#include <cstddef>
+
+// For std::strtod, std::strtoul
+#include <cstdlib>
+
+// For std::string
+#include <string>
+
+// For std::vector
+#include <vector>
+
+// For std::ostream, std::istream
+#include <ostream>
+#include <istream>
+
+// For std::istreambuf_iterator
+#include <iterator>
+
+// For std::setprecision
+#include <iomanip>
+
+
+// Baselines are JSON files of the form:
+//   { "version": 1, "results": [ { "name": "...", "ns_per_op": 1.25 }, ... ] }
+// Only the name and ns_per_op of each result are read back,
+// so the files may be edited or extended by hand.
+
+struct baseline_entry
+{
+	std::string name;
+	double nanoseconds_per_operation;
+};
+
+// Escapes text for a JSON string, including every control character
+inline void write_json_string(std::ostream & stream, const std::string & text)
+{
+	const char digits[] = "0123456789abcdef";
+
+	stream << '"';
+
+	for (const char character : text)
+	{
+		const unsigned char code = static_cast<unsigned char>(character);
+
+		if ((character == '"') || (character == '\\'))
+			stream << '\\' << character;
+		else if (character == '\n')
+			stream << "\\n";
+		else if (character == '\r')
+			stream << "\\r";
+		else if (character == '\t')
+			stream << "\\t";
+		else if (code < 0x20)
+			stream << "\\u00" << digits[code >> 4] << digits[code & 0xF];
+		else
+			stream << character;
+	}
+
+	stream << '"';
+}
+
+// Reads the JSON string starting at the opening quote at index, undoing the escapes.
+// Returns the index of the closing quote, or text.size() if there is none.
+inline std::size_t read_json_string(const std::string & text, std::size_t index, std::string & result)
+{
+	for (++index; (index < text.size()) && (text[index] != '"'); ++index)
+	{
+		if ((text[index] != '\\') || ((index + 1) >= text.size()))
+		{
+			result += text[index];
+			continue;
+		}
+
+		const char escaped = text[++index];
+
+		if (escaped == 'n')
+			result += '\n';
+		else if (escaped == 'r')
+			result += '\r';
+		else if (escaped == 't')
+			result += '\t';
+		else if (escaped == 'b')
+			result += '\b';
+		else if (escaped == 'f')
+			result += '\f';
+		else if ((escaped == 'u') && ((index + 4) < text.size()))
+		{
+			const unsigned long code = std::strtoul(text.substr(index + 1, 4).c_str(), nullptr, 16);
+
+			// Names are written a byte at a time, so only \u00XX is expected
+			result += static_cast<char>(code & 0xFF);
+			index += 4;
+		}
+		else
+			result += escaped;
+	}
+
+	return index;
+}
+
+template<typename Results>
+void write_benchmark_baseline(std::ostream & stream, const Results & results)
+{
+	stream << "{\n\t\"version\": 1,\n\t\"results\": [";
+
+	for (std::size_t index = 0; index < results.size(); ++index)
+	{
+		stream << ((index > 0) ? ",\n\t\t" : "\n\t\t") << "{ \"name\": ";
+		write_json_string(stream, results[index].name);
+		stream << ", \"ns_per_op\": " << std::setprecision(6) << results[index].nanoseconds_per_operation << " }";
+	}
+
+	stream << "\n\t]\n}\n";
+}
+
+// Reads every name and ns_per_op pair in the file, in order.
+// Returns false if the file holds no results at all.
+inline bool read_benchmark_baseline(std::istream & stream, std::vector<baseline_entry> & entries)
+{
+	const std::string text { std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>() };
+
+	const std::string name_key = "\"name\"";
+	const std::string time_key = "\"ns_per_op\"";
+
+	for (std::size_t position = text.find(name_key); position != std::string::npos; position = text.find(name_key, position))
+	{
+		// Read the quoted name, undoing the escapes
+		std::size_t index = text.find('"', text.find(':', position + name_key.size()));
+
+		if (index == std::string::npos)
+			break;
+
+		std::string name;
+		index = read_json_string(text, index, name);
+
+		// Then the time that follows it
+		const std::size_t time = text.find(time_key, index);
+
+		if (time == std::string::npos)
+			break;
+
+		const std::size_t colon = text.find(':', time + time_key.size());
+		const double value = std::strtod(text.c_str() + colon + 1, nullptr);
+
+		entries.push_back(baseline_entry { name, value });
+		position = colon;
+	}
+
+	return !entries.empty();
+}
@@ -0,0 +1,87 @@
+#!/bin/sh
+
+#
+#  Copyright (C) 2020 Pharap (@Pharap)
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#       http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+#
+
+# Disassembles the kernels in codegen_kernels.cpp,
+# printing the instruction and conditional branch count of each.
+#
+# Fails if circular_deque's push_back or pop_front contain any conditional branch
+# for a power of two capacity, as those are expected to be a mask and nothing more.
+#
+# Usage, from the repository root:
+#   benchmarks/check_codegen.sh [compiler] [extra flags...]
+
+set -eu
+
+compiler="${1:-${CXX:-c++}}"
+[ "$#" -gt 0 ] && shift
+
+directory="$(cd "$(dirname "$0")" && pwd)"
+object="$(mktemp "${TMPDIR:-/tmp}/codegen_kernels.XXXXXX")"
+trap 'rm -f "$object"' EXIT
+
+"$compiler" -std=c++14 -O2 -DNDEBUG -I"$directory/.." -c "$directory/codegen_kernels.cpp" -o "$object" "$@"
+
+# Prints "name instructions branches" for every kernel.
+# Conditional branches are x86 jcc/loop and AArch64/ARM b.cond, cbz, cbnz, tbz, tbnz.
+objdump -d --no-show-raw-insn "$object" | awk '
+	/^[0-9a-f]+ <[A-Za-z0-9_]+>:$/ {
+		if (name != "") print name, instructions, branches
+		name = $2
+		gsub(/[<>:]/, "", name)
+		instructions = 0
+		branches = 0
+		next
+	}
+	/^ *[0-9a-f]+:\t/ {
+		split($0, fields, "\t")
+		mnemonic = fields[2]
+		sub(/ .*/, "", mnemonic)
+		if (mnemonic == "" || mnemonic ~ /^(nop|xchg|data16|cs)/) next
+		++instructions
+		if (mnemonic ~ /^j/ && mnemonic !~ /^jmp/) ++branches
+		else if (mnemonic ~ /^loop/) ++branches
+		else if (mnemonic ~ /^(b\.|cbn?z|tbn?z)/) ++branches
+	}
+	END { if (name != "") print name, instructions, branches }
+' > "$object.counts"
+trap 'rm -f "$object" "$object.counts"' EXIT
+
+printf '%-28s %12s %9s\n' kernel instructions branches
+sort "$object.counts" | while read -r name instructions branches
+do
+	printf '%-28s %12s %9s\n' "$name" "$instructions" "$branches"
+done
+
+status=0
+
+for kernel in deque_pow2_push_back deque_pow2_pop_front
+do
+	branches="$(awk -v kernel="$kernel" '$1 == kernel { print $3 }' "$object.counts")"
+
+	if [ -z "$branches" ]
+	then
+		echo "error: $kernel was not found in the disassembly" >&2
+		status=1
+	elif [ "$branches" -ne 0 ]
+	then
+		echo "error: $kernel has $branches conditional branch(es), expected none" >&2
+		status=1
+	fi
+done
+
+exit "$status"
@@ -0,0 +1,66 @@
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// The hot paths compiled on their own, with unmangled names,
+// for check_codegen.sh to disassemble.
+// Not meant to be linked into a program.
+
+// For std::uint32_t
+#include <cstdint>
+
+// For circular_deque
+#include "circular_deque.h"
+
+// For the index strategies, strategy_ring
+#include "index_strategies.h"
+
+
+using value_type = std::uint32_t;
+
+using deque_pow2 = circular_deque<value_type, 1024>;
+using deque_other = circular_deque<value_type, 1000>;
+using ternary_pow2 = strategy_ring<value_type, 1024, ternary_strategy>;
+using modulo_pow2 = strategy_ring<value_type, 1024, modulo_strategy>;
+using mask_pow2 = strategy_ring<value_type, 1024, mask_strategy>;
+using subtract_pow2 = strategy_ring<value_type, 1024, subtract_strategy>;
+using ternary_other = strategy_ring<value_type, 1000, ternary_strategy>;
+using modulo_other = strategy_ring<value_type, 1000, modulo_strategy>;
+using subtract_other = strategy_ring<value_type, 1000, subtract_strategy>;
+
+// Defines the four end operations of Ring, prefixed by its name
+#define CODEGEN_KERNELS(Ring) \
+	void Ring##_push_back(Ring & ring, value_type value) { ring.push_back(value); } \
+	void Ring##_push_front(Ring & ring, value_type value) { ring.push_front(value); } \
+	void Ring##_pop_back(Ring & ring) { ring.pop_back(); } \
+	void Ring##_pop_front(Ring & ring) { ring.pop_front(); }
+
+extern "C"
+{
+	// The deque itself, with and without a power of two capacity
+	CODEGEN_KERNELS(deque_pow2)
+	CODEGEN_KERNELS(deque_other)
+
+	// Each strategy, for comparison
+	CODEGEN_KERNELS(ternary_pow2)
+	CODEGEN_KERNELS(modulo_pow2)
+	CODEGEN_KERNELS(mask_pow2)
+	CODEGEN_KERNELS(subtract_pow2)
+	CODEGEN_KERNELS(ternary_other)
+	CODEGEN_KERNELS(modulo_other)
+	CODEGEN_KERNELS(subtract_other)
+}
+
+#undef CODEGEN_KERNELS
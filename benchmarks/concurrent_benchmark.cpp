@@ -0,0 +1,502 @@
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// Measures the throughput and round-trip latency of queues
+// shared between threads pinned to chosen cores.
+//
+// Build from the repository root with:
+//   g++ -std=c++17 -O2 -DNDEBUG -pthread -I. benchmarks/concurrent_benchmark.cpp -o concurrent_benchmark
+//
+// Pass --cpus 0,2,4,6 to choose the cores, threads are assigned to them in turn.
+// The spinning variant is skipped unless there are at least two different cores to run on.
+
+// For std::size_t
+#include <cstddef>
+
+// For std::uint64_t
+#include <cstdint>
+
+// For std::strtoul
+#include <cstdlib>
+
+// For std::mutex, std::lock_guard
+#include <mutex>
+
+// For std::thread
+#include <thread>
+
+// For std::atomic
+#include <atomic>
+
+// For std::vector
+#include <vector>
+
+// For std::string, std::to_string
+#include <string>
+
+// For std::min, std::sort, std::unique
+#include <algorithm>
+
+// For std::chrono::steady_clock
+#include <chrono>
+
+// For std::cerr
+#include <iostream>
+
+#if defined(__linux__)
+// For pthread_setaffinity_np, cpu_set_t
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// For circular_deque
+#include "circular_deque.h"
+
+// For blocking_circular_deque, the wait strategies
+#include "blocking_circular_deque.h"
+
+// For latency_histogram
+#include "latency_histogram.h"
+
+// For steady_clock_source
+#include "trace_clock.h"
+
+// For benchmark_runner
+#include "benchmark.h"
+
+
+constexpr std::size_t queue_capacity = 1024;
+constexpr std::size_t throughput_items = (std::size_t(1) << 20);
+constexpr std::size_t latency_rounds = (std::size_t(1) << 16);
+
+
+// The baseline every other variant is compared against:
+// a circular_deque guarded by a std::mutex.
+//
+// Every variant offers the same batch interface,
+// each call moves as many values as it can without waiting
+// and returns how many it moved.
+template<typename Type, std::size_t capacity>
+class mutex_queue
+{
+public:
+	static constexpr const char * name = "mutex_circular_deque";
+	static constexpr bool blocking = false;
+
+private:
+	std::mutex mutex;
+	circular_deque<Type, capacity> deque;
+
+public:
+	std::size_t try_push(const Type * values, std::size_t amount)
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+
+		const std::size_t free = (this->deque.max_size() - this->deque.size());
+		const std::size_t pushed = std::min(amount, free);
+
+		for (std::size_t index = 0; index < pushed; ++index)
+			this->deque.push_back(values[index]);
+
+		return pushed;
+	}
+
+	std::size_t try_pop(Type * values, std::size_t amount)
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+
+		const std::size_t popped = std::min(amount, this->deque.size());
+
+		for (std::size_t index = 0; index < popped; ++index)
+		{
+			values[index] = this->deque.front();
+			this->deque.pop_front();
+		}
+
+		return popped;
+	}
+};
+
+
+// A blocking_circular_deque, whose round trips use the blocking push and pop
+// so the wait strategy is measured rather than the benchmark's own backoff
+template<typename Type, std::size_t capacity, typename WaitStrategy>
+class blocking_queue : public blocking_circular_deque<Type, capacity, WaitStrategy>
+{
+public:
+	static inline const std::string name = ("blocking_" + std::string(WaitStrategy::name));
+	static constexpr bool blocking = true;
+};
+
+
+// Spins briefly, then gives the core away,
+// so oversubscribed runs still make progress
+class backoff
+{
+private:
+	std::size_t spins = 0;
+
+public:
+	void pause()
+	{
+		if (this->spins < 64)
+		{
+			++this->spins;
+			benchmark_clobber();
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	void reset()
+	{
+		this->spins = 0;
+	}
+};
+
+class cpu_list
+{
+private:
+	std::vector<int> cpus;
+	bool is_valid = true;
+
+public:
+	// Parses a comma separated list,
+	// or uses every core if there is no list.
+	// A malformed list, like "x", "1,,2" or "1,", leaves the list invalid.
+	explicit cpu_list(const char * list)
+	{
+		if (list != nullptr)
+			this->is_valid = this->parse(list);
+
+		if (this->cpus.empty())
+		{
+			const unsigned count = std::thread::hardware_concurrency();
+
+			for (unsigned cpu = 0; cpu < ((count > 0) ? count : 1); ++cpu)
+				this->cpus.push_back(static_cast<int>(cpu));
+		}
+	}
+
+	bool valid() const
+	{
+		return this->is_valid;
+	}
+
+	std::size_t size() const
+	{
+		return this->cpus.size();
+	}
+
+	// The number of different cores, as a list may name one more than once
+	std::size_t distinct_count() const
+	{
+		std::vector<int> distinct(this->cpus);
+		std::sort(distinct.begin(), distinct.end());
+
+		return static_cast<std::size_t>(std::unique(distinct.begin(), distinct.end()) - distinct.begin());
+	}
+
+	// Pins the calling thread to the core for the thread_index'th thread
+	void pin(std::size_t thread_index) const
+	{
+#if defined(__linux__)
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(this->cpus[thread_index % this->cpus.size()], &set);
+		pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+		static_cast<void>(thread_index);
+#endif
+	}
+
+private:
+	bool parse(const char * list)
+	{
+		for (const char * text = list;;)
+		{
+			// std::strtoul would also accept spaces and signs
+			if ((*text < '0') || (*text > '9'))
+				return false;
+
+			char * end = nullptr;
+			const unsigned long cpu = std::strtoul(text, &end, 10);
+
+			if (end == text)
+				return false;
+
+#if defined(__linux__)
+			// A cpu_set_t has no room for larger core numbers
+			if (cpu >= CPU_SETSIZE)
+				return false;
+#endif
+
+			this->cpus.push_back(static_cast<int>(cpu));
+
+			if (*end == '\0')
+				return true;
+
+			if (*end != ',')
+				return false;
+
+			text = (end + 1);
+		}
+	}
+};
+
+
+// Moves throughput_items values from the producers to the consumers,
+// returning the nanoseconds it took
+template<typename Queue>
+double measure_throughput(const cpu_list & cpus, std::size_t producers, std::size_t consumers, std::size_t batch)
+{
+	Queue queue;
+	std::atomic<bool> start { false };
+	std::atomic<std::size_t> consumed { 0 };
+	std::vector<std::thread> threads;
+
+	const std::size_t per_producer = (throughput_items / producers);
+	const std::size_t total = (per_producer * producers);
+
+	for (std::size_t producer = 0; producer < producers; ++producer)
+	{
+		threads.emplace_back([&, producer]()
+		{
+			cpus.pin(producer);
+
+			std::vector<std::uint64_t> values(batch, producer);
+			backoff waiter;
+
+			while (!start.load(std::memory_order_acquire))
+				waiter.pause();
+
+			for (std::size_t sent = 0; sent < per_producer;)
+			{
+				const std::size_t pushed = queue.try_push(values.data(), std::min(batch, (per_producer - sent)));
+
+				if (pushed > 0)
+					waiter.reset();
+				else
+					waiter.pause();
+
+				sent += pushed;
+			}
+		});
+	}
+
+	for (std::size_t consumer = 0; consumer < consumers; ++consumer)
+	{
+		threads.emplace_back([&, consumer]()
+		{
+			cpus.pin(producers + consumer);
+
+			std::vector<std::uint64_t> values(batch);
+			backoff waiter;
+
+			while (!start.load(std::memory_order_acquire))
+				waiter.pause();
+
+			while (consumed.load(std::memory_order_relaxed) < total)
+			{
+				const std::size_t popped = queue.try_pop(values.data(), batch);
+
+				if (popped > 0)
+				{
+					waiter.reset();
+					consumed.fetch_add(popped, std::memory_order_relaxed);
+				}
+				else
+				{
+					waiter.pause();
+				}
+			}
+		});
+	}
+
+	const auto begin = std::chrono::steady_clock::now();
+	start.store(true, std::memory_order_release);
+
+	for (auto & thread : threads)
+		thread.join();
+
+	const auto end = std::chrono::steady_clock::now();
+
+	return std::chrono::duration<double, std::nano>(end - begin).count();
+}
+
+// Bounces a timestamp between two threads through a pair of queues,
+// recording each round trip
+template<typename Queue>
+latency_histogram<> measure_round_trip(const cpu_list & cpus)
+{
+	Queue request;
+	Queue reply;
+	latency_histogram<> histogram;
+
+	// Both ends run on threads of their own,
+	// so that pinning them leaves the main thread's affinity alone
+	std::thread echo([&]()
+	{
+		cpus.pin(1);
+
+		if constexpr (Queue::blocking)
+		{
+			for (std::size_t round = 0; round < latency_rounds; ++round)
+				reply.push(request.pop());
+
+			return;
+		}
+
+		backoff waiter;
+		std::uint64_t value = 0;
+
+		for (std::size_t round = 0; round < latency_rounds; ++round)
+		{
+			while (request.try_pop(&value, 1) == 0)
+				waiter.pause();
+
+			waiter.reset();
+
+			while (reply.try_push(&value, 1) == 0)
+				waiter.pause();
+		}
+	});
+
+	std::thread initiator([&]()
+	{
+		cpus.pin(0);
+
+		backoff waiter;
+
+		for (std::size_t round = 0; round < latency_rounds; ++round)
+		{
+			std::uint64_t value = steady_clock_source::now();
+
+			if constexpr (Queue::blocking)
+			{
+				request.push(value);
+				value = reply.pop();
+			}
+			else
+			{
+				while (request.try_push(&value, 1) == 0)
+					waiter.pause();
+
+				while (reply.try_pop(&value, 1) == 0)
+					waiter.pause();
+
+				waiter.reset();
+			}
+
+			histogram.record(steady_clock_source::now() - value);
+		}
+	});
+
+	initiator.join();
+	echo.join();
+
+	return histogram;
+}
+
+template<typename Queue>
+void run_variant(benchmark_runner & runner, const cpu_list & cpus)
+{
+	const std::string name = Queue::name;
+
+	for (std::size_t threads = 1; threads <= 4; threads *= 2)
+	{
+		for (std::size_t batch : { std::size_t(1), std::size_t(8), std::size_t(64) })
+		{
+			const std::string case_name = ("throughput/" + std::to_string(threads) + "p" + std::to_string(threads) + "c/batch" + std::to_string(batch) + '/' + name);
+
+			if (!runner.selected(case_name))
+				continue;
+
+			double best = 0;
+
+			for (std::size_t repetition = 0; repetition < runner.settings().repetitions; ++repetition)
+			{
+				const double nanoseconds = measure_throughput<Queue>(cpus, threads, threads, batch);
+
+				if ((repetition == 0) || (nanoseconds < best))
+					best = nanoseconds;
+			}
+
+			const std::size_t items = ((throughput_items / threads) * threads);
+			runner.record(benchmark_result { case_name, items, (best / static_cast<double>(items)) });
+		}
+	}
+
+	// Each statistic is a case of its own, so the filter can select any of them
+	const struct
+	{
+		const char * label;
+		double percentile;
+	}
+	statistics[] { { "p50", 50.0 }, { "p99", 99.0 }, { "p99.9", 99.9 }, { "max", 100.0 } };
+
+	bool any_selected = false;
+
+	for (const auto & entry : statistics)
+		if (runner.selected("round_trip/" + std::string(entry.label) + '/' + name))
+			any_selected = true;
+
+	if (!any_selected)
+		return;
+
+	const latency_histogram<> histogram = measure_round_trip<Queue>(cpus);
+
+	for (const auto & entry : statistics)
+	{
+		const std::string case_name = ("round_trip/" + std::string(entry.label) + '/' + name);
+
+		// The 100th percentile is the maximum
+		if (runner.selected(case_name))
+			runner.record(benchmark_result { case_name, 1, static_cast<double>(histogram.value_at_percentile(entry.percentile)) });
+	}
+}
+
+int main(int argc, char ** argv)
+{
+	benchmark_options options;
+
+	if (!parse_benchmark_options(argc, argv, options))
+		return 1;
+
+	const cpu_list cpus(options.cpus);
+
+	if (!cpus.valid())
+	{
+		std::cerr << argv[0] << ": --cpus expects a comma separated list of core numbers, not \"" << options.cpus << "\"\n";
+		return 1;
+	}
+
+	benchmark_runner runner(options);
+
+	run_variant<mutex_queue<std::uint64_t, queue_capacity>>(runner, cpus);
+
+	// Spinning waiters starve the thread they wait on if the two share a core,
+	// which pinning forces when the list names fewer than two different cores
+	if ((std::thread::hardware_concurrency() > 1) && (cpus.distinct_count() > 1))
+		run_variant<blocking_queue<std::uint64_t, queue_capacity, spin_wait_strategy>>(runner, cpus);
+
+	run_variant<blocking_queue<std::uint64_t, queue_capacity, yield_wait_strategy>>(runner, cpus);
+	run_variant<blocking_queue<std::uint64_t, queue_capacity, futex_wait_strategy>>(runner, cpus);
+
+	return runner.finish();
+}
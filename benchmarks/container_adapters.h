@@ -0,0 +1,271 @@
+#pragma once
+
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// For std::size_t
+#include <cstddef>
+
+// For std::array
+#include <array>
+
+// For std::deque
+#include <deque>
+
+// For std::queue
+#include <queue>
+
+// For std::vector
+#include <vector>
+
+// For std::unique_ptr, std::make_unique
+#include <memory>
+
+// For std::find
+#include <algorithm>
+
+// For circular_deque
+#include "circular_deque.h"
+
+#if defined(__has_include)
+#if __has_include(<boost/circular_buffer.hpp>)
+#include <boost/circular_buffer.hpp>
+#define CIRCULAR_DEQUE_BENCHMARK_BOOST 1
+#endif
+#endif
+
+
+// An element of a chosen size
+template<std::size_t size>
+struct payload
+{
+	std::array<unsigned char, size> bytes;
+
+	bool operator ==(const payload & other) const
+	{
+		return (this->bytes == other.bytes);
+	}
+};
+
+template<std::size_t size>
+payload<size> make_payload(unsigned char value)
+{
+	payload<size> result;
+	result.bytes.fill(value);
+	return result;
+}
+
+
+// A ring over a std::vector with a capacity chosen at runtime
+template<typename Type>
+class vector_ring
+{
+private:
+	std::vector<Type> storage;
+	std::size_t head = 0;
+	std::size_t count = 0;
+
+public:
+	explicit vector_ring(std::size_t capacity) :
+		storage(capacity)
+	{
+	}
+
+	void push_back(const Type & value)
+	{
+		this->storage[this->wrap(this->head + this->count)] = value;
+		++this->count;
+	}
+
+	void push_front(const Type & value)
+	{
+		this->head = (this->head > 0) ? (this->head - 1) : (this->storage.size() - 1);
+		this->storage[this->head] = value;
+		++this->count;
+	}
+
+	void pop_back()
+	{
+		--this->count;
+	}
+
+	void pop_front()
+	{
+		this->head = this->wrap(this->head + 1);
+		--this->count;
+	}
+
+	template<typename Function>
+	void for_each(Function function) const
+	{
+		for (std::size_t index = 0; index < this->count; ++index)
+			function(this->storage[this->wrap(this->head + index)]);
+	}
+
+	bool contains(const Type & value) const
+	{
+		for (std::size_t index = 0; index < this->count; ++index)
+			if (this->storage[this->wrap(this->head + index)] == value)
+				return true;
+
+		return false;
+	}
+
+	void clear()
+	{
+		this->head = 0;
+		this->count = 0;
+	}
+
+private:
+	std::size_t wrap(std::size_t index) const
+	{
+		return (index < this->storage.size()) ? index : (index - this->storage.size());
+	}
+};
+
+
+// Adapters give every container the same interface,
+// and say which operations the container supports
+
+template<typename Type, std::size_t capacity>
+struct circular_deque_adapter
+{
+	static constexpr const char * name = "circular_deque";
+	static constexpr bool double_ended = true;
+	static constexpr bool iterable = true;
+
+	// Large deques would overflow the stack
+	std::unique_ptr<circular_deque<Type, capacity>> container = std::make_unique<circular_deque<Type, capacity>>();
+
+	explicit circular_deque_adapter(std::size_t) {}
+
+	void push_back(const Type & value) { this->container->push_back(value); }
+	void push_front(const Type & value) { this->container->push_front(value); }
+	void pop_back() { this->container->pop_back(); }
+	void pop_front() { this->container->pop_front(); }
+	bool contains(const Type & value) const { return this->container->contains(value); }
+	void clear() { this->container->clear(); }
+
+	template<typename Function>
+	void for_each(Function function)
+	{
+		for (auto & value : *this->container)
+			function(value);
+	}
+};
+
+template<typename Type>
+struct deque_adapter
+{
+	static constexpr const char * name = "std::deque";
+	static constexpr bool double_ended = true;
+	static constexpr bool iterable = true;
+
+	std::deque<Type> container;
+
+	explicit deque_adapter(std::size_t) {}
+
+	void push_back(const Type & value) { this->container.push_back(value); }
+	void push_front(const Type & value) { this->container.push_front(value); }
+	void pop_back() { this->container.pop_back(); }
+	void pop_front() { this->container.pop_front(); }
+	bool contains(const Type & value) const { return (std::find(this->container.begin(), this->container.end(), value) != this->container.end()); }
+	void clear() { this->container.clear(); }
+
+	template<typename Function>
+	void for_each(Function function)
+	{
+		for (auto & value : this->container)
+			function(value);
+	}
+};
+
+template<typename Type>
+struct queue_adapter
+{
+	static constexpr const char * name = "std::queue";
+	static constexpr bool double_ended = false;
+	static constexpr bool iterable = false;
+
+	std::queue<Type> container;
+
+	explicit queue_adapter(std::size_t) {}
+
+	void push_back(const Type & value) { this->container.push(value); }
+	void pop_front() { this->container.pop(); }
+};
+
+template<typename Type>
+struct vector_ring_adapter
+{
+	static constexpr const char * name = "vector_ring";
+	static constexpr bool double_ended = true;
+	static constexpr bool iterable = true;
+
+	vector_ring<Type> container;
+
+	explicit vector_ring_adapter(std::size_t capacity) :
+		container(capacity)
+	{
+	}
+
+	void push_back(const Type & value) { this->container.push_back(value); }
+	void push_front(const Type & value) { this->container.push_front(value); }
+	void pop_back() { this->container.pop_back(); }
+	void pop_front() { this->container.pop_front(); }
+	bool contains(const Type & value) const { return this->container.contains(value); }
+	void clear() { this->container.clear(); }
+
+	template<typename Function>
+	void for_each(Function function)
+	{
+		this->container.for_each(function);
+	}
+};
+
+#if defined(CIRCULAR_DEQUE_BENCHMARK_BOOST)
+
+template<typename Type>
+struct boost_adapter
+{
+	static constexpr const char * name = "boost::circular_buffer";
+	static constexpr bool double_ended = true;
+	static constexpr bool iterable = true;
+
+	boost::circular_buffer<Type> container;
+
+	explicit boost_adapter(std::size_t capacity) :
+		container(capacity)
+	{
+	}
+
+	void push_back(const Type & value) { this->container.push_back(value); }
+	void push_front(const Type & value) { this->container.push_front(value); }
+	void pop_back() { this->container.pop_back(); }
+	void pop_front() { this->container.pop_front(); }
+	bool contains(const Type & value) const { return (std::find(this->container.begin(), this->container.end(), value) != this->container.end()); }
+	void clear() { this->container.clear(); }
+
+	template<typename Function>
+	void for_each(Function function)
+	{
+		for (auto & value : this->container)
+			function(value);
+	}
+};
+
+#endif
@@ -0,0 +1,190 @@
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// Compares circular_deque against the standard containers.
+//
+// Build from the repository root with:
+//   g++ -std=c++17 -O2 -DNDEBUG -I. benchmarks/container_benchmark.cpp -o container_benchmark
+
+// For std::size_t
+#include <cstddef>
+
+// For std::string, std::to_string
+#include <string>
+
+// For payload, the container adapters
+#include "container_adapters.h"
+
+// For benchmark_runner
+#include "benchmark.h"
+
+
+// The total number of operations each case aims for,
+// small capacities repeat their cycle until they reach it
+constexpr std::size_t target_operations = (std::size_t(1) << 21);
+
+template<typename Adapter, std::size_t bytes>
+void run_container(benchmark_runner & runner, std::size_t capacity)
+{
+	using value_type = payload<bytes>;
+
+	const std::string suffix = ('/' + std::to_string(bytes) + "B/" + std::to_string(capacity) + '/' + Adapter::name);
+	const std::size_t cycles = ((target_operations / capacity) > 0) ? (target_operations / capacity) : 1;
+
+	const value_type present = make_payload<bytes>(1);
+	const value_type absent = make_payload<bytes>(2);
+
+	Adapter adapter(capacity);
+
+	const auto fill = [&]()
+	{
+		for (std::size_t index = 0; index < capacity; ++index)
+			adapter.push_back(present);
+	};
+
+	const auto drain = [&]()
+	{
+		for (std::size_t index = 0; index < capacity; ++index)
+			adapter.pop_front();
+	};
+
+	if constexpr (Adapter::double_ended)
+	{
+		runner.run("push_pop_back" + suffix, (2 * capacity * cycles), [&]()
+		{
+			for (std::size_t cycle = 0; cycle < cycles; ++cycle)
+			{
+				for (std::size_t index = 0; index < capacity; ++index)
+					adapter.push_back(present);
+
+				for (std::size_t index = 0; index < capacity; ++index)
+					adapter.pop_back();
+			}
+		});
+
+		runner.run("push_pop_front" + suffix, (2 * capacity * cycles), [&]()
+		{
+			for (std::size_t cycle = 0; cycle < cycles; ++cycle)
+			{
+				for (std::size_t index = 0; index < capacity; ++index)
+					adapter.push_front(present);
+
+				for (std::size_t index = 0; index < capacity; ++index)
+					adapter.pop_front();
+			}
+		});
+	}
+
+	// Half full, so the indices wrap around during the run
+	for (std::size_t index = 0; index < (capacity / 2); ++index)
+		adapter.push_back(present);
+
+	runner.run("fifo_churn" + suffix, (capacity * cycles), [&]()
+	{
+		for (std::size_t index = 0; index < (capacity * cycles); ++index)
+		{
+			adapter.push_back(present);
+			adapter.pop_front();
+		}
+	});
+
+	for (std::size_t index = 0; index < (capacity / 2); ++index)
+		adapter.pop_front();
+
+	if constexpr (Adapter::iterable)
+	{
+		fill();
+
+		runner.run("iterate" + suffix, (capacity * cycles), [&]()
+		{
+			unsigned sum = 0;
+
+			for (std::size_t cycle = 0; cycle < cycles; ++cycle)
+			{
+				adapter.for_each([&sum](const value_type & value) { sum += value.bytes[0]; });
+				benchmark_clobber();
+			}
+
+			benchmark_keep(sum);
+		});
+
+		runner.run("contains" + suffix, (capacity * cycles), [&]()
+		{
+			bool found = false;
+
+			for (std::size_t cycle = 0; cycle < cycles; ++cycle)
+			{
+				found |= adapter.contains(absent);
+				benchmark_clobber();
+			}
+
+			benchmark_keep(found);
+		});
+
+		drain();
+
+		// Measured per object cleared
+		runner.run("clear" + suffix, capacity, fill, [&]()
+		{
+			adapter.clear();
+		});
+	}
+}
+
+template<std::size_t bytes, std::size_t capacity>
+void run_capacity(benchmark_runner & runner)
+{
+	if (capacity > runner.settings().maximum_capacity)
+		return;
+
+	using value_type = payload<bytes>;
+
+	run_container<circular_deque_adapter<value_type, capacity>, bytes>(runner, capacity);
+	run_container<deque_adapter<value_type>, bytes>(runner, capacity);
+	run_container<queue_adapter<value_type>, bytes>(runner, capacity);
+	run_container<vector_ring_adapter<value_type>, bytes>(runner, capacity);
+
+#if defined(CIRCULAR_DEQUE_BENCHMARK_BOOST)
+	run_container<boost_adapter<value_type>, bytes>(runner, capacity);
+#endif
+}
+
+template<std::size_t bytes>
+void run_size(benchmark_runner & runner)
+{
+	run_capacity<bytes, 16>(runner);
+	run_capacity<bytes, 256>(runner);
+	run_capacity<bytes, 4096>(runner);
+	run_capacity<bytes, 65536>(runner);
+	run_capacity<bytes, (std::size_t(1) << 20)>(runner);
+}
+
+int main(int argc, char ** argv)
+{
+	benchmark_options options;
+
+	if (!parse_benchmark_options(argc, argv, options))
+		return 1;
+
+	benchmark_runner runner(options);
+
+	run_size<1>(runner);
+	run_size<8>(runner);
+	run_size<64>(runner);
+	run_size<256>(runner);
+
+	return runner.finish();
+}
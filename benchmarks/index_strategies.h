@@ -0,0 +1,158 @@
+#pragma once
+
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// For std::size_t
+#include <cstddef>
+
+// For std::array
+#include <array>
+
+
+// The ways a ring can step an index forwards and backwards.
+// Each is used by strategy_ring below, which otherwise matches circular_deque.
+
+// What circular_deque does for capacities that aren't a power of two
+struct ternary_strategy
+{
+	static constexpr const char * name = "ternary";
+
+	template<std::size_t capacity>
+	static constexpr std::size_t next(std::size_t index)
+	{
+		return (index < (capacity - 1)) ? (index + 1) : 0;
+	}
+
+	template<std::size_t capacity>
+	static constexpr std::size_t previous(std::size_t index)
+	{
+		return (index > 0) ? (index - 1) : (capacity - 1);
+	}
+};
+
+struct modulo_strategy
+{
+	static constexpr const char * name = "modulo";
+
+	template<std::size_t capacity>
+	static constexpr std::size_t next(std::size_t index)
+	{
+		return ((index + 1) % capacity);
+	}
+
+	template<std::size_t capacity>
+	static constexpr std::size_t previous(std::size_t index)
+	{
+		return ((index + capacity - 1) % capacity);
+	}
+};
+
+// Only correct for power of two capacities
+struct mask_strategy
+{
+	static constexpr const char * name = "mask";
+
+	template<std::size_t capacity>
+	static constexpr std::size_t next(std::size_t index)
+	{
+		static_assert((capacity & (capacity - 1)) == 0, "mask_strategy needs a power of two capacity");
+		return ((index + 1) & (capacity - 1));
+	}
+
+	template<std::size_t capacity>
+	static constexpr std::size_t previous(std::size_t index)
+	{
+		static_assert((capacity & (capacity - 1)) == 0, "mask_strategy needs a power of two capacity");
+		return ((index - 1) & (capacity - 1));
+	}
+};
+
+struct subtract_strategy
+{
+	static constexpr const char * name = "subtract";
+
+	template<std::size_t capacity>
+	static constexpr std::size_t next(std::size_t index)
+	{
+		const std::size_t result = (index + 1);
+		return result - ((result >= capacity) ? capacity : 0);
+	}
+
+	template<std::size_t capacity>
+	static constexpr std::size_t previous(std::size_t index)
+	{
+		const std::size_t result = (index + capacity - 1);
+		return result - ((result >= capacity) ? capacity : 0);
+	}
+};
+
+
+// A minimal ring with circular_deque's layout and operations,
+// parameterised on the index strategy
+template<typename Type, std::size_t capacity, typename Strategy>
+class strategy_ring
+{
+private:
+	std::size_t count = 0;
+	std::size_t back_index = (capacity / 2);
+	std::size_t front_index = ((capacity / 2) - 1);
+	std::array<Type, capacity> array {};
+
+public:
+	std::size_t size() const
+	{
+		return this->count;
+	}
+
+	void push_back(const Type & value)
+	{
+		this->array[this->back_index] = value;
+		this->back_index = Strategy::template next<capacity>(this->back_index);
+		++this->count;
+	}
+
+	void push_front(const Type & value)
+	{
+		this->array[this->front_index] = value;
+		this->front_index = Strategy::template previous<capacity>(this->front_index);
+		++this->count;
+	}
+
+	void pop_back()
+	{
+		this->back_index = Strategy::template previous<capacity>(this->back_index);
+		--this->count;
+	}
+
+	void pop_front()
+	{
+		this->front_index = Strategy::template next<capacity>(this->front_index);
+		--this->count;
+	}
+
+	template<typename Function>
+	void for_each(Function function) const
+	{
+		std::size_t index = Strategy::template next<capacity>(this->front_index);
+
+		for (std::size_t remaining = this->count; remaining > 0; --remaining)
+		{
+			function(this->array[index]);
+			index = Strategy::template next<capacity>(index);
+		}
+	}
+};
@@ -0,0 +1,166 @@
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// Compares the ways of stepping a ring index on the push, pop and iterate kernels.
+// See check_codegen.sh for the matching instruction and branch counts.
+//
+// Build from the repository root with:
+//   g++ -std=c++17 -O2 -DNDEBUG -I. benchmarks/index_strategy_benchmark.cpp -o index_strategy_benchmark
+
+// For std::size_t
+#include <cstddef>
+
+// For std::uint32_t
+#include <cstdint>
+
+// For std::string, std::to_string
+#include <string>
+
+// For std::unique_ptr, std::make_unique
+#include <memory>
+
+// For circular_deque
+#include "circular_deque.h"
+
+// For the index strategies, strategy_ring
+#include "index_strategies.h"
+
+// For benchmark_runner
+#include "benchmark.h"
+
+
+constexpr std::size_t target_operations = (std::size_t(1) << 22);
+
+// Gives circular_deque the same name as the strategy rings
+struct circular_deque_strategy
+{
+	static constexpr const char * name = "circular_deque";
+};
+
+template<typename Type, std::size_t capacity, typename Function>
+void visit(circular_deque<Type, capacity> & ring, Function function)
+{
+	for (auto & value : ring)
+		function(value);
+}
+
+template<typename Type, std::size_t capacity, typename Strategy, typename Function>
+void visit(const strategy_ring<Type, capacity, Strategy> & ring, Function function)
+{
+	ring.for_each(function);
+}
+
+template<typename Ring, typename Strategy, std::size_t capacity>
+void run_ring(benchmark_runner & runner)
+{
+	using value_type = std::uint32_t;
+
+	const std::string suffix = ('/' + std::to_string(capacity) + '/' + Strategy::name);
+	const std::size_t cycles = (target_operations / capacity);
+
+	auto ring = std::make_unique<Ring>();
+
+	runner.run("push_pop_back" + suffix, (2 * capacity * cycles), [&]()
+	{
+		for (std::size_t cycle = 0; cycle < cycles; ++cycle)
+		{
+			for (std::size_t index = 0; index < capacity; ++index)
+				ring->push_back(static_cast<value_type>(index));
+
+			for (std::size_t index = 0; index < capacity; ++index)
+				ring->pop_back();
+		}
+	});
+
+	runner.run("push_pop_front" + suffix, (2 * capacity * cycles), [&]()
+	{
+		for (std::size_t cycle = 0; cycle < cycles; ++cycle)
+		{
+			for (std::size_t index = 0; index < capacity; ++index)
+				ring->push_front(static_cast<value_type>(index));
+
+			for (std::size_t index = 0; index < capacity; ++index)
+				ring->pop_front();
+		}
+	});
+
+	// Half full, so the indices wrap around during the run
+	for (std::size_t index = 0; index < (capacity / 2); ++index)
+		ring->push_back(static_cast<value_type>(index));
+
+	runner.run("fifo_churn" + suffix, (capacity * cycles), [&]()
+	{
+		for (std::size_t index = 0; index < (capacity * cycles); ++index)
+		{
+			ring->push_back(static_cast<value_type>(index));
+			ring->pop_front();
+		}
+	});
+
+	runner.run("iterate" + suffix, ((capacity / 2) * cycles), [&]()
+	{
+		value_type sum = 0;
+
+		for (std::size_t cycle = 0; cycle < cycles; ++cycle)
+		{
+			visit(*ring, [&sum](const value_type & value) { sum += value; });
+			benchmark_clobber();
+		}
+
+		benchmark_keep(sum);
+	});
+}
+
+template<std::size_t capacity, typename Strategy>
+void run_strategy(benchmark_runner & runner)
+{
+	run_ring<strategy_ring<std::uint32_t, capacity, Strategy>, Strategy, capacity>(runner);
+}
+
+template<std::size_t capacity>
+void run_capacity(benchmark_runner & runner)
+{
+	if (capacity > runner.settings().maximum_capacity)
+		return;
+
+	run_ring<circular_deque<std::uint32_t, capacity>, circular_deque_strategy, capacity>(runner);
+	run_strategy<capacity, ternary_strategy>(runner);
+	run_strategy<capacity, modulo_strategy>(runner);
+	run_strategy<capacity, subtract_strategy>(runner);
+
+	if constexpr ((capacity & (capacity - 1)) == 0)
+		run_strategy<capacity, mask_strategy>(runner);
+}
+
+int main(int argc, char ** argv)
+{
+	benchmark_options options;
+
+	if (!parse_benchmark_options(argc, argv, options))
+		return 1;
+
+	benchmark_runner runner(options);
+
+	// Power of two capacities, and their neighbours that aren't
+	run_capacity<64>(runner);
+	run_capacity<100>(runner);
+	run_capacity<4096>(runner);
+	run_capacity<4000>(runner);
+	run_capacity<65536>(runner);
+	run_capacity<65000>(runner);
+
+	return runner.finish();
+}
@@ -0,0 +1,189 @@
+#pragma once
+
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// For std::size_t
+#include <cstddef>
+
+// For std::uint64_t
+#include <cstdint>
+
+// For std::array
+#include <array>
+
+// For std::numeric_limits
+#include <limits>
+
+#if defined(__linux__)
+// For perf_event_attr, PERF_* constants
+#include <linux/perf_event.h>
+
+// For syscall, SYS_perf_event_open
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// For ioctl
+#include <sys/ioctl.h>
+
+#define CIRCULAR_DEQUE_HAS_PERF_EVENTS 1
+#else
+#define CIRCULAR_DEQUE_HAS_PERF_EVENTS 0
+#endif
+
+
+enum class perf_counter
+{
+	cycles,
+	instructions,
+	branch_misses,
+	l1d_misses,
+	llc_misses,
+};
+
+constexpr std::size_t perf_counter_count = 5;
+
+// Counter totals between a start and a stop.
+// A counter the kernel or hardware couldn't provide reads as NaN.
+struct perf_counter_values
+{
+	std::array<double, perf_counter_count> values;
+
+	perf_counter_values()
+	{
+		this->values.fill(std::numeric_limits<double>::quiet_NaN());
+	}
+
+	double operator [](perf_counter counter) const
+	{
+		return this->values[static_cast<std::size_t>(counter)];
+	}
+
+	double & operator [](perf_counter counter)
+	{
+		return this->values[static_cast<std::size_t>(counter)];
+	}
+};
+
+
+// Counts hardware events for the calling thread with perf_event_open.
+//
+// Every counter is opened separately, so one missing event
+// (common in virtual machines) doesn't lose the rest.
+// If none can be opened, available() is false and every value is NaN.
+class perf_counters
+{
+private:
+	std::array<int, perf_counter_count> descriptors;
+
+public:
+	perf_counters()
+	{
+		this->descriptors.fill(-1);
+
+#if CIRCULAR_DEQUE_HAS_PERF_EVENTS
+		this->open(perf_counter::cycles, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+		this->open(perf_counter::instructions, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+		this->open(perf_counter::branch_misses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+		this->open(perf_counter::l1d_misses, PERF_TYPE_HW_CACHE, (PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)));
+		this->open(perf_counter::llc_misses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+#endif
+	}
+
+	~perf_counters()
+	{
+#if CIRCULAR_DEQUE_HAS_PERF_EVENTS
+		for (int descriptor : this->descriptors)
+			if (descriptor >= 0)
+				close(descriptor);
+#endif
+	}
+
+	perf_counters(const perf_counters &) = delete;
+	perf_counters & operator =(const perf_counters &) = delete;
+
+	bool available() const
+	{
+		for (int descriptor : this->descriptors)
+			if (descriptor >= 0)
+				return true;
+
+		return false;
+	}
+
+	void start()
+	{
+#if CIRCULAR_DEQUE_HAS_PERF_EVENTS
+		for (int descriptor : this->descriptors)
+			if (descriptor >= 0)
+			{
+				ioctl(descriptor, PERF_EVENT_IOC_RESET, 0);
+				ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+			}
+#endif
+	}
+
+	perf_counter_values stop()
+	{
+		perf_counter_values result;
+
+#if CIRCULAR_DEQUE_HAS_PERF_EVENTS
+		for (int descriptor : this->descriptors)
+			if (descriptor >= 0)
+				ioctl(descriptor, PERF_EVENT_IOC_DISABLE, 0);
+
+		for (std::size_t index = 0; index < perf_counter_count; ++index)
+		{
+			if (this->descriptors[index] < 0)
+				continue;
+
+			// Value, time enabled, time running
+			std::uint64_t buffer[3] {};
+
+			if (read(this->descriptors[index], buffer, sizeof(buffer)) != static_cast<ssize_t>(sizeof(buffer)))
+				continue;
+
+			// Scale up counters the kernel had to multiplex
+			if ((buffer[2] > 0) && (buffer[2] < buffer[1]))
+				result.values[index] = (static_cast<double>(buffer[0]) * (static_cast<double>(buffer[1]) / static_cast<double>(buffer[2])));
+			else if (buffer[2] > 0)
+				result.values[index] = static_cast<double>(buffer[0]);
+		}
+#endif
+
+		return result;
+	}
+
+private:
+#if CIRCULAR_DEQUE_HAS_PERF_EVENTS
+	void open(perf_counter counter, std::uint32_t type, std::uint64_t config)
+	{
+		perf_event_attr attributes {};
+		attributes.size = sizeof(attributes);
+		attributes.type = type;
+		attributes.config = config;
+		attributes.disabled = 1;
+		attributes.exclude_kernel = 1;
+		attributes.exclude_hv = 1;
+		attributes.read_format = (PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING);
+
+		// This thread, any CPU, no group
+		const long descriptor = syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0);
+
+		this->descriptors[static_cast<std::size_t>(counter)] = static_cast<int>(descriptor);
+	}
+#endif
+};
@@ -0,0 +1,225 @@
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// Replays a trace captured with recording_circular_deque
+// against each container, as fast as possible.
+//
+// Build from the repository root with:
+//   g++ -std=c++17 -O2 -DNDEBUG -I. benchmarks/replay_benchmark.cpp -o replay_benchmark
+//
+// Run with:
+//   ./replay_benchmark --input capture.cdqt
+
+// For std::size_t
+#include <cstddef>
+
+// For std::uint64_t
+#include <cstdint>
+
+// For std::ifstream
+#include <fstream>
+
+// For std::vector
+#include <vector>
+
+// For std::string
+#include <string>
+
+// For operation_trace_reader, trace_record
+#include "operation_trace.h"
+
+// For payload, the container adapters
+#include "container_adapters.h"
+
+// For benchmark_runner
+#include "benchmark.h"
+
+
+struct loaded_trace
+{
+	trace_header header;
+	std::vector<trace_record> records;
+	std::uint64_t peak_size = 0;
+	std::uint64_t duration = 0;
+	bool double_ended = false;
+	bool clears = false;
+};
+
+template<typename Adapter, std::size_t bytes>
+void replay(benchmark_runner & runner, const loaded_trace & trace, std::size_t capacity)
+{
+	if constexpr (!Adapter::double_ended)
+		// Adapters that can only queue can't replay the other operations
+		if (trace.double_ended || trace.clears)
+			return;
+
+	const payload<bytes> value = make_payload<bytes>(1);
+
+	Adapter adapter(capacity);
+
+	const auto reset = [&]()
+	{
+		if constexpr (Adapter::double_ended)
+			adapter.clear();
+	};
+
+	runner.run(("replay/" + std::to_string(bytes) + "B/" + std::to_string(capacity) + '/' + Adapter::name), trace.records.size(), reset, [&]()
+	{
+		for (const trace_record & record : trace.records)
+		{
+			switch (record.operation)
+			{
+				case trace_operation::push_back:
+					adapter.push_back(value);
+					break;
+
+				case trace_operation::pop_front:
+					adapter.pop_front();
+					break;
+
+				case trace_operation::push_front:
+					if constexpr (Adapter::double_ended)
+						adapter.push_front(value);
+					break;
+
+				case trace_operation::pop_back:
+					if constexpr (Adapter::double_ended)
+						adapter.pop_back();
+					break;
+
+				case trace_operation::clear:
+					if constexpr (Adapter::double_ended)
+						adapter.clear();
+					break;
+			}
+		}
+	});
+}
+
+template<std::size_t bytes, std::size_t capacity>
+void replay_all(benchmark_runner & runner, const loaded_trace & trace)
+{
+	using value_type = payload<bytes>;
+
+	replay<circular_deque_adapter<value_type, capacity>, bytes>(runner, trace, capacity);
+	replay<deque_adapter<value_type>, bytes>(runner, trace, capacity);
+	replay<queue_adapter<value_type>, bytes>(runner, trace, capacity);
+	replay<vector_ring_adapter<value_type>, bytes>(runner, trace, capacity);
+
+#if defined(CIRCULAR_DEQUE_BENCHMARK_BOOST)
+	replay<boost_adapter<value_type>, bytes>(runner, trace, capacity);
+#endif
+}
+
+// The largest benchmarked element size
+constexpr std::size_t max_element_size = 4096;
+
+// The most memory one replayed container may take up
+constexpr std::size_t max_container_bytes = (std::size_t(1) << 30);
+
+// Picks the smallest benchmarked capacity that holds the trace's peak size,
+// skipping those whose containers would be too large for elements this big
+template<std::size_t bytes>
+bool replay_size(benchmark_runner & runner, const loaded_trace & trace)
+{
+	if (trace.peak_size <= 1024)
+		replay_all<bytes, 1024>(runner, trace);
+	else if (trace.peak_size <= 4096)
+		replay_all<bytes, 4096>(runner, trace);
+	else if ((trace.peak_size <= 65536) && ((bytes * 65536) <= max_container_bytes))
+		replay_all<bytes, 65536>(runner, trace);
+	else if ((trace.peak_size <= (std::size_t(1) << 20)) && ((bytes << 20) <= max_container_bytes))
+		replay_all<bytes, (std::size_t(1) << 20)>(runner, trace);
+	else
+		return false;
+
+	return true;
+}
+
+int main(int argc, char ** argv)
+{
+	benchmark_options options;
+
+	if (!parse_benchmark_options(argc, argv, options))
+		return 1;
+
+	if (options.input == nullptr)
+	{
+		std::cerr << "replay_benchmark needs a trace, pass it with --input path\n";
+		return 1;
+	}
+
+	std::ifstream stream(options.input, std::ios::binary);
+	operation_trace_reader reader(stream);
+
+	if (!reader.good())
+	{
+		std::cerr << options.input << " is not a circular_deque operation trace\n";
+		return 1;
+	}
+
+	loaded_trace trace;
+	trace.header = reader.header();
+
+	for (trace_record record; reader.read(record);)
+	{
+		trace.records.push_back(record);
+		trace.duration += record.delta;
+
+		if (record.size > trace.peak_size)
+			trace.peak_size = record.size;
+
+		if ((record.operation == trace_operation::push_front) || (record.operation == trace_operation::pop_back))
+			trace.double_ended = true;
+
+		if (record.operation == trace_operation::clear)
+			trace.clears = true;
+	}
+
+	std::cerr << trace.records.size() << " operations over " << trace.duration << " ticks, ";
+	std::cerr << "peak size " << trace.peak_size << ", recorded element size " << trace.header.element_size << " B\n";
+
+	// Replaying larger elements with smaller ones would understate their cost
+	if (trace.header.element_size > max_element_size)
+	{
+		std::cerr << "The trace's element size is larger than the largest benchmarked one, " << max_element_size << " B\n";
+		return 1;
+	}
+
+	benchmark_runner runner(options);
+
+	// Replay with the nearest benchmarked element size that isn't smaller
+	bool replayed = false;
+
+	if (trace.header.element_size <= 8)
+		replayed = replay_size<8>(runner, trace);
+	else if (trace.header.element_size <= 64)
+		replayed = replay_size<64>(runner, trace);
+	else if (trace.header.element_size <= 256)
+		replayed = replay_size<256>(runner, trace);
+	else if (trace.header.element_size <= 1024)
+		replayed = replay_size<1024>(runner, trace);
+	else
+		replayed = replay_size<max_element_size>(runner, trace);
+
+	if (!replayed)
+	{
+		std::cerr << "The trace's peak size is larger than any benchmarked capacity for its element size\n";
+		return 1;
+	}
+
+	return runner.finish();
+}
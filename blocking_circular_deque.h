@@ -0,0 +1,489 @@
+#pragma once
+
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// For std::size_t
+#include <cstddef>
+
+// For std::uint32_t
+#include <cstdint>
+
+// For std::atomic
+#include <atomic>
+
+// For std::mutex, std::lock_guard, std::unique_lock
+#include <mutex>
+
+// For std::this_thread::yield
+#include <thread>
+
+// For std::move
+#include <utility>
+
+// For std::min
+#include <algorithm>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+// For _mm_pause
+#include <intrin.h>
+#endif
+
+#if defined(__linux__)
+// For syscall, SYS_futex
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// For FUTEX_WAIT_PRIVATE, FUTEX_WAKE_PRIVATE
+#include <linux/futex.h>
+
+#define CIRCULAR_DEQUE_HAS_FUTEX 1
+#else
+// For std::condition_variable
+#include <condition_variable>
+
+#define CIRCULAR_DEQUE_HAS_FUTEX 0
+#endif
+
+// For circular_deque, circular_deque_no_statistics
+#include "circular_deque.h"
+
+
+// Tells the core this thread is spinning,
+// which saves power and frees resources for a sibling hyperthread
+inline void circular_deque_cpu_relax()
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	_mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+	asm volatile("yield" ::: "memory");
+#endif
+}
+
+
+// Wait strategies for blocking_circular_deque.
+//
+// Each one tracks a single condition with an epoch counter:
+// a waiter reads the epoch with prepare() before checking the condition,
+// then calls wait() with what it read if the condition didn't hold.
+// wait() returns once the epoch has moved on, or spuriously,
+// so the waiter must check the condition again.
+// Any change to the condition must be followed by notify_one() or notify_all().
+
+// Busy waits, for the lowest wake up latency.
+// Burns a whole core while waiting, so only suits threads with a core to themselves.
+class spin_wait_strategy
+{
+public:
+	static constexpr const char * name = "spin";
+
+private:
+	std::atomic<std::uint32_t> epoch { 0 };
+
+public:
+	std::uint32_t prepare() const
+	{
+		return this->epoch.load(std::memory_order_acquire);
+	}
+
+	void wait(std::uint32_t observed) const
+	{
+		while (this->epoch.load(std::memory_order_acquire) == observed)
+			circular_deque_cpu_relax();
+	}
+
+	void notify_one()
+	{
+		this->epoch.fetch_add(1, std::memory_order_release);
+	}
+
+	void notify_all()
+	{
+		this->epoch.fetch_add(1, std::memory_order_release);
+	}
+};
+
+// Spins for a while, then yields the core between checks.
+// Wakes almost as quickly as spinning when the wait is short,
+// and lets other threads run when it isn't.
+class yield_wait_strategy
+{
+public:
+	static constexpr const char * name = "spin_yield";
+
+	static constexpr std::size_t spin_limit = 128;
+
+private:
+	std::atomic<std::uint32_t> epoch { 0 };
+
+public:
+	std::uint32_t prepare() const
+	{
+		return this->epoch.load(std::memory_order_acquire);
+	}
+
+	void wait(std::uint32_t observed) const
+	{
+		for (std::size_t spins = 0; this->epoch.load(std::memory_order_acquire) == observed; ++spins)
+		{
+			if (spins < spin_limit)
+				circular_deque_cpu_relax();
+			else
+				std::this_thread::yield();
+		}
+	}
+
+	void notify_one()
+	{
+		this->epoch.fetch_add(1, std::memory_order_release);
+	}
+
+	void notify_all()
+	{
+		this->epoch.fetch_add(1, std::memory_order_release);
+	}
+};
+
+// Spins briefly, then parks the thread in the kernel until notified.
+// Waiting costs no CPU, and notifying costs no system call while nobody is parked.
+//
+// On Linux the thread parks on the epoch itself with a futex,
+// elsewhere it parks on a std::condition_variable.
+class futex_wait_strategy
+{
+public:
+	static constexpr const char * name = "futex";
+
+	static constexpr std::size_t spin_limit = 64;
+
+private:
+	std::atomic<std::uint32_t> epoch { 0 };
+	std::atomic<std::uint32_t> waiters { 0 };
+
+#if !CIRCULAR_DEQUE_HAS_FUTEX
+	std::mutex mutex;
+	std::condition_variable condition;
+#endif
+
+public:
+	std::uint32_t prepare() const
+	{
+		return this->epoch.load(std::memory_order_seq_cst);
+	}
+
+	void wait(std::uint32_t observed)
+	{
+		for (std::size_t spins = 0; spins < spin_limit; ++spins)
+		{
+			if (this->epoch.load(std::memory_order_acquire) != observed)
+				return;
+
+			circular_deque_cpu_relax();
+		}
+
+		// Announce the waiter before the final check of the epoch,
+		// so a notifier either sees the waiter or the waiter sees the new epoch
+		this->waiters.fetch_add(1, std::memory_order_seq_cst);
+
+#if CIRCULAR_DEQUE_HAS_FUTEX
+		static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t), "futex_wait_strategy needs a plain 32 bit atomic");
+
+		// The kernel only sleeps if the epoch still holds the observed value,
+		// and the loop absorbs spurious and stolen wake ups
+		while (this->epoch.load(std::memory_order_seq_cst) == observed)
+			syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&this->epoch), FUTEX_WAIT_PRIVATE, observed, nullptr, nullptr, 0);
+#else
+		{
+			std::unique_lock<std::mutex> lock(this->mutex);
+
+			while (this->epoch.load(std::memory_order_seq_cst) == observed)
+				this->condition.wait(lock);
+		}
+#endif
+
+		this->waiters.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	void notify_one()
+	{
+		this->notify(1);
+	}
+
+	void notify_all()
+	{
+		this->notify(static_cast<int>(~0u >> 1));
+	}
+
+private:
+	void notify(int count)
+	{
+		this->epoch.fetch_add(1, std::memory_order_seq_cst);
+
+		if (this->waiters.load(std::memory_order_seq_cst) == 0)
+			return;
+
+#if CIRCULAR_DEQUE_HAS_FUTEX
+		syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&this->epoch), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+#else
+		// Taking the lock orders the notification after a waiter's final check
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+		}
+
+		if (count == 1)
+			this->condition.notify_one();
+		else
+			this->condition.notify_all();
+#endif
+	}
+};
+
+
+// A circular_deque shared between threads,
+// whose push waits while it is full and whose pop waits while it is empty.
+//
+// Values go in at the back and come out at the front.
+// The deque itself is guarded by a mutex, held only while it is modified;
+// the WaitStrategy decides how threads wait for room or for values.
+template<typename Type, std::size_t capacity_value, typename WaitStrategy = futex_wait_strategy, typename Statistics = circular_deque_no_statistics>
+class blocking_circular_deque
+{
+public:
+	using deque_type = circular_deque<Type, capacity_value, Statistics>;
+	using value_type = Type;
+	using size_type = std::size_t;
+	using wait_strategy_type = WaitStrategy;
+	using statistics_type = Statistics;
+
+public:
+	static constexpr size_type capacity = capacity_value;
+
+private:
+	mutable std::mutex mutex;
+	deque_type deque {};
+	wait_strategy_type not_empty;
+	wait_strategy_type not_full;
+
+public:
+	blocking_circular_deque() = default;
+
+	blocking_circular_deque(const blocking_circular_deque &) = delete;
+	blocking_circular_deque & operator =(const blocking_circular_deque &) = delete;
+
+	// O(1)
+	// Only a snapshot, other threads may change it at any time
+	bool empty() const
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		return this->deque.empty();
+	}
+
+	// O(1)
+	// Only a snapshot, other threads may change it at any time
+	bool full() const
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		return this->deque.full();
+	}
+
+	// O(1)
+	// Only a snapshot, other threads may change it at any time
+	size_type size() const
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		return this->deque.size();
+	}
+
+	// O(1)
+	constexpr size_type max_size() const
+	{
+		return capacity;
+	}
+
+	// O(1)
+	// Only a snapshot, other threads may change it at any time
+	statistics_type statistics() const
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		return this->deque.statistics();
+	}
+
+	// O(1)
+	// The statistics policy itself, without taking the lock.
+	// Only safe to read while other threads use the deque if the policy is made for it,
+	// like circular_deque_published_statistics.
+	const statistics_type & published_statistics() const
+	{
+		return this->deque.statistics();
+	}
+
+	// O(1)
+	// Waits while the deque is full
+	void push(const value_type & value)
+	{
+		this->wait_for_room([this, &value]() { this->deque.push_back(value); });
+	}
+
+	// O(1)
+	// Waits while the deque is full
+	void push(value_type && value)
+	{
+		this->wait_for_room([this, &value]() { this->deque.push_back(std::move(value)); });
+	}
+
+	// O(1)
+	// Waits while the deque is empty
+	value_type pop()
+	{
+		value_type result;
+
+		this->wait_for_value([this, &result]()
+		{
+			result = std::move(this->deque.front());
+			this->deque.pop_front();
+		});
+
+		return result;
+	}
+
+	// O(1)
+	// Returns false instead of waiting if the deque is full
+	bool try_push(const value_type & value)
+	{
+		bool pushed = false;
+
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+
+			// Lets the deque's statistics count the rejection
+			pushed = this->deque.try_push_back(value);
+		}
+
+		if (pushed)
+			this->not_empty.notify_one();
+
+		return pushed;
+	}
+
+	// O(1)
+	// Returns false instead of waiting if the deque is empty
+	bool try_pop(value_type & value)
+	{
+		return (this->try_pop(&value, 1) == 1);
+	}
+
+	// O(n)
+	// Pushes as many of the values as there is room for, without waiting.
+	// Returns how many were pushed.
+	size_type try_push(const value_type * values, size_type amount)
+	{
+		size_type pushed = 0;
+
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+
+			// Stops at the first value there's no room for,
+			// which the deque's statistics count as a rejection
+			while ((pushed < amount) && this->deque.try_push_back(values[pushed]))
+				++pushed;
+		}
+
+		this->notify(this->not_empty, pushed);
+
+		return pushed;
+	}
+
+	// O(n)
+	// Pops up to amount values into values, without waiting.
+	// Returns how many were popped.
+	size_type try_pop(value_type * values, size_type amount)
+	{
+		size_type popped = 0;
+
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+
+			popped = std::min(amount, this->deque.size());
+
+			for (size_type index = 0; index < popped; ++index)
+			{
+				values[index] = std::move(this->deque.front());
+				this->deque.pop_front();
+			}
+		}
+
+		this->notify(this->not_full, popped);
+
+		return popped;
+	}
+
+private:
+	template<typename Operation>
+	void wait_for_room(Operation operation)
+	{
+		for (;;)
+		{
+			const auto observed = this->not_full.prepare();
+
+			{
+				std::lock_guard<std::mutex> lock(this->mutex);
+
+				if (!this->deque.full())
+				{
+					operation();
+					break;
+				}
+			}
+
+			this->not_full.wait(observed);
+		}
+
+		this->not_empty.notify_one();
+	}
+
+	template<typename Operation>
+	void wait_for_value(Operation operation)
+	{
+		for (;;)
+		{
+			const auto observed = this->not_empty.prepare();
+
+			{
+				std::lock_guard<std::mutex> lock(this->mutex);
+
+				if (!this->deque.empty())
+				{
+					operation();
+					break;
+				}
+			}
+
+			this->not_empty.wait(observed);
+		}
+
+		this->not_full.notify_one();
+	}
+
+	static void notify(wait_strategy_type & condition, size_type amount)
+	{
+		if (amount == 1)
+			condition.notify_one();
+		else if (amount > 1)
+			condition.notify_all();
+	}
+};
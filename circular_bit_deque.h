@@ -0,0 +1,447 @@
+#pragma once
+
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// For std::size_t
+#include <cstddef>
+
+// For std::uint64_t
+#include <cstdint>
+
+// For std::array
+#include <array>
+
+// For assert
+#include <cassert>
+
+
+// A circular deque of flags, packed 64 to a word.
+//
+// Queries work a word at a time: count() uses popcount,
+// find_first() and find_last() count trailing and leading zeros,
+// and push_back(word, amount) and shift_in(word, amount) append up to 64 flags at once.
+// Because the capacity is a whole number of words, the ring only wraps between words.
+template<std::size_t capacity_value>
+class circular_bit_deque
+{
+public:
+	static_assert(capacity_value > 0, "Attempt to instantiate circular_bit_deque with a capacity of 0");
+	static_assert((capacity_value % 64) == 0, "circular_bit_deque needs a capacity that is a multiple of 64");
+
+public:
+	using value_type = bool;
+	using size_type = std::size_t;
+	using word_type = std::uint64_t;
+
+public:
+	static constexpr size_type capacity = capacity_value;
+	static constexpr size_type word_bits = 64;
+	static constexpr size_type word_count = (capacity / word_bits);
+
+private:
+	// The flag at the front, as an index into the bits of the array
+	size_type first = 0;
+	size_type length = 0;
+	std::array<word_type, word_count> words {};
+
+public:
+	constexpr circular_bit_deque() = default;
+
+	// O(1)
+	constexpr bool empty() const
+	{
+		return (this->size() == 0);
+	}
+
+	// O(1)
+	constexpr bool full() const
+	{
+		return (this->size() == this->max_size());
+	}
+
+	// O(1)
+	constexpr size_type size() const
+	{
+		return this->length;
+	}
+
+	// O(1)
+	constexpr size_type max_size() const
+	{
+		return capacity;
+	}
+
+	// O(1)
+	// The flag at offset from the front
+	bool test(size_type offset) const
+	{
+		assert(offset < this->size());
+		return this->get_bit(this->bit_index(offset));
+	}
+
+	// O(1)
+	bool operator [](size_type offset) const
+	{
+		return this->test(offset);
+	}
+
+	// O(1)
+	void set(size_type offset, bool value = true)
+	{
+		assert(offset < this->size());
+		this->set_bit(this->bit_index(offset), value);
+	}
+
+	// O(1)
+	bool back() const
+	{
+		assert(!this->empty());
+		return this->get_bit(this->bit_index(this->length - 1));
+	}
+
+	// O(1)
+	bool front() const
+	{
+		assert(!this->empty());
+		return this->get_bit(this->first);
+	}
+
+	// O(1)
+	// Up to 64 flags starting at offset from the front,
+	// the first in the lowest bit
+	word_type bits(size_type offset, size_type amount = word_bits) const
+	{
+		assert(amount <= word_bits);
+		assert(offset <= this->size());
+		assert(amount <= (this->size() - offset));
+
+		const size_type index = this->bit_index(offset);
+		const size_type word = (index / word_bits);
+		const size_type bit = (index % word_bits);
+
+		word_type result = (this->words[word] >> bit);
+
+		// If the flags carry on into the next word
+		if ((bit + amount) > word_bits)
+			result |= (this->words[next_word(word)] << (word_bits - bit));
+
+		return (result & low_mask(amount));
+	}
+
+	// O(1)
+	void push_back(bool value)
+	{
+		// Ensure the deque isn't full
+		assert(!this->full());
+
+		this->set_bit(this->bit_index(this->length), value);
+		++this->length;
+	}
+
+	// O(1)
+	void push_front(bool value)
+	{
+		// Ensure the deque isn't full
+		assert(!this->full());
+
+		this->first = (this->first > 0) ? (this->first - 1) : (capacity - 1);
+		this->set_bit(this->first, value);
+		++this->length;
+	}
+
+	// O(1)
+	// Appends the lowest amount bits of word, lowest first
+	void push_back(word_type word, size_type amount)
+	{
+		// Ensure the deque has room for them
+		assert(amount <= word_bits);
+		assert(amount <= (this->max_size() - this->size()));
+
+		// If there's nothing to push
+		if (amount == 0)
+			return;
+
+		const size_type index = this->bit_index(this->length);
+		const size_type target = (index / word_bits);
+		const size_type bit = (index % word_bits);
+
+		// Fill the rest of the word holding the back
+		const size_type low_amount = ((word_bits - bit) < amount) ? (word_bits - bit) : amount;
+		const word_type low_bits = (low_mask(low_amount) << bit);
+
+		this->words[target] = ((this->words[target] & ~low_bits) | ((word << bit) & low_bits));
+
+		// Then carry the remainder into the next word
+		if (low_amount < amount)
+		{
+			const word_type high_bits = low_mask(amount - low_amount);
+			const size_type next = next_word(target);
+
+			this->words[next] = ((this->words[next] & ~high_bits) | ((word >> low_amount) & high_bits));
+		}
+
+		this->length += amount;
+	}
+
+	// O(1)
+	// Appends the lowest amount bits of word, lowest first,
+	// first popping as many flags from the front as are needed to make room.
+	// Slides a fixed size window along a stream of flags.
+	void shift_in(word_type word, size_type amount)
+	{
+		assert(amount <= word_bits);
+
+		const size_type free = (capacity - this->length);
+
+		if (amount > free)
+			this->pop_front(amount - free);
+
+		this->push_back(word, amount);
+	}
+
+	// O(1)
+	void pop_back()
+	{
+		// Ensure the deque isn't empty
+		assert(!this->empty());
+
+		--this->length;
+	}
+
+	// O(1)
+	void pop_front()
+	{
+		// Ensure the deque isn't empty
+		assert(!this->empty());
+
+		this->first = (this->first < (capacity - 1)) ? (this->first + 1) : 0;
+		--this->length;
+	}
+
+	// O(1)
+	void pop_back(size_type amount)
+	{
+		// Ensure the deque holds enough flags
+		assert(amount <= this->size());
+
+		this->length -= amount;
+	}
+
+	// O(1)
+	void pop_front(size_type amount)
+	{
+		// Ensure the deque holds enough flags
+		assert(amount <= this->size());
+
+		this->first = this->bit_index(amount);
+		this->length -= amount;
+	}
+
+	// O(1)
+	void clear()
+	{
+		this->first = 0;
+		this->length = 0;
+	}
+
+	// O(n / 64)
+	// The number of set flags
+	size_type count() const
+	{
+		const size_type front_end = this->front_run_end();
+
+		return (this->count_bits(this->first, front_end) + this->count_bits(0, (this->length - (front_end - this->first))));
+	}
+
+	// O(n / 64)
+	// The offset of the first set flag, or size() if there is none
+	size_type find_first() const
+	{
+		const size_type front_end = this->front_run_end();
+		const size_type front_amount = (front_end - this->first);
+
+		// Search the front run first
+		const size_type front_found = this->find_first_bit(this->first, front_end);
+
+		if (front_found != front_end)
+			return (front_found - this->first);
+
+		// Then the back run
+		const size_type back_end = (this->length - front_amount);
+		const size_type back_found = this->find_first_bit(0, back_end);
+
+		return (front_amount + back_found);
+	}
+
+	// O(n / 64)
+	// The offset of the last set flag, or size() if there is none
+	size_type find_last() const
+	{
+		const size_type front_end = this->front_run_end();
+		const size_type front_amount = (front_end - this->first);
+
+		// Search the back run first
+		const size_type back_end = (this->length - front_amount);
+		const size_type back_found = this->find_last_bit(0, back_end);
+
+		if (back_found != back_end)
+			return (front_amount + back_found);
+
+		// Then the front run
+		const size_type front_found = this->find_last_bit(this->first, front_end);
+
+		return (front_found != front_end) ? (front_found - this->first) : this->length;
+	}
+
+private:
+	// Converts an offset from the front into an index into the bits of the array
+	constexpr size_type bit_index(size_type offset) const
+	{
+		return (this->first < (capacity - offset)) ? (this->first + offset) : (this->first + offset - capacity);
+	}
+
+	// The end of the flags that come before the wrap
+	constexpr size_type front_run_end() const
+	{
+		return (this->length < (capacity - this->first)) ? (this->first + this->length) : capacity;
+	}
+
+	bool get_bit(size_type index) const
+	{
+		return (((this->words[index / word_bits] >> (index % word_bits)) & 1) != 0);
+	}
+
+	void set_bit(size_type index, bool value)
+	{
+		const word_type bit = (word_type(1) << (index % word_bits));
+		word_type & word = this->words[index / word_bits];
+
+		word = value ? (word | bit) : (word & ~bit);
+	}
+
+	// The set bits among the array bits in [begin, end)
+	size_type count_bits(size_type begin, size_type end) const
+	{
+		size_type result = 0;
+
+		while (begin < end)
+		{
+			const size_type bit = (begin % word_bits);
+			const size_type amount = ((end - begin) < (word_bits - bit)) ? (end - begin) : (word_bits - bit);
+
+			result += popcount(this->words[begin / word_bits] & (low_mask(amount) << bit));
+			begin += amount;
+		}
+
+		return result;
+	}
+
+	// The first set bit among the array bits in [begin, end), or end
+	size_type find_first_bit(size_type begin, size_type end) const
+	{
+		while (begin < end)
+		{
+			const size_type bit = (begin % word_bits);
+			const size_type amount = ((end - begin) < (word_bits - bit)) ? (end - begin) : (word_bits - bit);
+			const word_type word = (this->words[begin / word_bits] & (low_mask(amount) << bit));
+
+			if (word != 0)
+				return ((begin - bit) + trailing_zeros(word));
+
+			begin += amount;
+		}
+
+		return end;
+	}
+
+	// The last set bit among the array bits in [begin, end), or end
+	size_type find_last_bit(size_type begin, size_type end) const
+	{
+		for (size_type current = end; current > begin;)
+		{
+			// The word holding the bit before current
+			const size_type word_begin = (((current - 1) / word_bits) * word_bits);
+			const size_type low = (word_begin > begin) ? word_begin : begin;
+			const word_type word = (this->words[word_begin / word_bits] & (low_mask(current - low) << (low - word_begin)));
+
+			if (word != 0)
+				return (word_begin + highest_bit(word));
+
+			current = low;
+		}
+
+		return end;
+	}
+
+	static constexpr size_type next_word(size_type word)
+	{
+		return (word < (word_count - 1)) ? (word + 1) : 0;
+	}
+
+	// A word with the lowest amount bits set
+	static constexpr word_type low_mask(size_type amount)
+	{
+		return (amount >= word_bits) ? ~word_type(0) : ((word_type(1) << amount) - 1);
+	}
+
+	static size_type popcount(word_type word)
+	{
+#if defined(__GNUC__)
+		return static_cast<size_type>(__builtin_popcountll(word));
+#else
+		size_type result = 0;
+
+		for (; word != 0; word &= (word - 1))
+			++result;
+
+		return result;
+#endif
+	}
+
+	// Requires a non-zero word
+	static size_type trailing_zeros(word_type word)
+	{
+#if defined(__GNUC__)
+		return static_cast<size_type>(__builtin_ctzll(word));
+#else
+		size_type result = 0;
+
+		while ((word & 1) == 0)
+		{
+			word >>= 1;
+			++result;
+		}
+
+		return result;
+#endif
+	}
+
+	// Requires a non-zero word
+	static size_type highest_bit(word_type word)
+	{
+#if defined(__GNUC__)
+		return static_cast<size_type>(63 - __builtin_clzll(word));
+#else
+		size_type result = 0;
+
+		while ((word >>= 1) != 0)
+			++result;
+
+		return result;
+#endif
+	}
+};
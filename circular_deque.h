@@ -31,21 +31,358 @@
 // For std::reverse_iterator, std::bidirectional_iterator_tag
 #include <iterator>
 
+// For std::lower_bound, std::upper_bound
+#include <algorithm>
 
-template<typename Type, std::size_t capacity>
+// For std::less
+#include <functional>
+
+// For std::is_trivially_copyable, std::is_trivially_destructible, std::is_integral, std::enable_if, std::integral_constant,
+// std::is_const, std::is_same, std::remove_const, std::conditional
+#include <type_traits>
+
+// For std::memcpy, std::memmove
+#include <cstring>
+
+// For placement new
+#include <new>
+
+
+// The default statistics policy.
+// Every hook is empty, so a deque using it compiles to the same code
+// as if it kept no statistics at all.
+class circular_deque_no_statistics
+{
+public:
+	using size_type = std::size_t;
+
+public:
+	void record_push_back(size_type, size_type) {}
+	void record_push_front(size_type, size_type) {}
+	void record_pop_back(size_type, size_type) {}
+	void record_pop_front(size_type, size_type) {}
+	void record_clear(size_type) {}
+	void record_full() {}
+	void record_empty() {}
+	void record_rejected_push() {}
+};
+
+
+// A statistics policy that counts the operations performed on a deque,
+// for sizing capacities from real workloads.
+//
+// Each push and pop hook receives the number of objects involved
+// and the size of the deque afterwards.
+class circular_deque_statistics
+{
+public:
+	using size_type = std::size_t;
+
+private:
+	size_type back_pushes = 0;
+	size_type front_pushes = 0;
+	size_type back_pops = 0;
+	size_type front_pops = 0;
+	size_type cleared = 0;
+	size_type high_water = 0;
+	size_type fulls = 0;
+	size_type empties = 0;
+	size_type rejected_pushes = 0;
+
+public:
+	// The number of objects pushed onto the back
+	constexpr size_type back_push_count() const
+	{
+		return this->back_pushes;
+	}
+
+	// The number of objects pushed onto the front
+	constexpr size_type front_push_count() const
+	{
+		return this->front_pushes;
+	}
+
+	// The number of objects popped from the back
+	constexpr size_type back_pop_count() const
+	{
+		return this->back_pops;
+	}
+
+	// The number of objects popped from the front
+	constexpr size_type front_pop_count() const
+	{
+		return this->front_pops;
+	}
+
+	// The number of objects pushed onto either end
+	constexpr size_type push_count() const
+	{
+		return (this->back_pushes + this->front_pushes);
+	}
+
+	// The number of objects popped from either end
+	constexpr size_type pop_count() const
+	{
+		return (this->back_pops + this->front_pops);
+	}
+
+	// The number of objects removed by clear
+	constexpr size_type clear_count() const
+	{
+		return this->cleared;
+	}
+
+	// The largest size the deque has reached
+	constexpr size_type high_water_mark() const
+	{
+		return this->high_water;
+	}
+
+	// The number of times a push left the deque full.
+	// Only counts the pushes that filled the deque,
+	// see rejected_push_count for the pushes turned away because it was full.
+	constexpr size_type full_count() const
+	{
+		return this->fulls;
+	}
+
+	// The number of times a pop or clear left the deque empty
+	constexpr size_type empty_count() const
+	{
+		return this->empties;
+	}
+
+	// The number of times try_push_back or try_push_front found the deque full
+	// and returned false instead of pushing
+	constexpr size_type rejected_push_count() const
+	{
+		return this->rejected_pushes;
+	}
+
+	void reset()
+	{
+		*this = circular_deque_statistics();
+	}
+
+public:
+	void record_push_back(size_type amount, size_type size)
+	{
+		this->back_pushes += amount;
+		this->record_size(size);
+	}
+
+	void record_push_front(size_type amount, size_type size)
+	{
+		this->front_pushes += amount;
+		this->record_size(size);
+	}
+
+	void record_pop_back(size_type amount, size_type)
+	{
+		this->back_pops += amount;
+	}
+
+	void record_pop_front(size_type amount, size_type)
+	{
+		this->front_pops += amount;
+	}
+
+	void record_clear(size_type amount)
+	{
+		this->cleared += amount;
+	}
+
+	void record_full()
+	{
+		++this->fulls;
+	}
+
+	void record_empty()
+	{
+		++this->empties;
+	}
+
+	void record_rejected_push()
+	{
+		++this->rejected_pushes;
+	}
+
+private:
+	void record_size(size_type size)
+	{
+		if (size > this->high_water)
+			this->high_water = size;
+	}
+};
+
+
+// Whether an object of Type may be moved to a new address by copying its bytes,
+// leaving nothing to be done for the old object.
+// Bulk operations relocate runs of such objects with std::memcpy
+// instead of moving and destroying them one by one.
+//
+// True for trivially copyable types. Most other types are relocatable too
+// (std::unique_ptr, most handle types), but only their author can say so:
+// specialise this for them as
+//   template<> struct circular_deque_is_trivially_relocatable<handle> : std::true_type {};
+// Types holding pointers into themselves, such as some std::string implementations, are not.
+template<typename Type>
+struct circular_deque_is_trivially_relocatable : std::is_trivially_copyable<Type>
+{
+};
+
+
+// A contiguous run of objects in a deque's underlying array
+template<typename Type>
+class circular_deque_span
+{
+public:
+	using value_type = Type;
+	using size_type = std::size_t;
+	using pointer = value_type *;
+	using iterator = pointer;
+
+private:
+	pointer pointer_value = nullptr;
+	size_type size_value = 0;
+
+public:
+	constexpr circular_deque_span() = default;
+
+	constexpr circular_deque_span(pointer data, size_type size) :
+		pointer_value { data }, size_value { size }
+	{
+	}
+
+	// O(1)
+	constexpr bool empty() const
+	{
+		return (this->size_value == 0);
+	}
+
+	// O(1)
+	constexpr size_type size() const
+	{
+		return this->size_value;
+	}
+
+	// O(1)
+	constexpr pointer data() const
+	{
+		return this->pointer_value;
+	}
+
+	// O(1)
+	constexpr iterator begin() const
+	{
+		return this->pointer_value;
+	}
+
+	// O(1)
+	constexpr iterator end() const
+	{
+		return (this->pointer_value + this->size_value);
+	}
+
+	// O(1)
+	value_type & operator [](size_type index) const
+	{
+		assert(index < this->size_value);
+		return this->pointer_value[index];
+	}
+};
+
+// A range of a deque's underlying array, split where it wraps around the end.
+// The first run comes before the second in deque order,
+// the second is only non-empty if the first is.
+template<typename Type>
+struct circular_deque_spans
+{
+	circular_deque_span<Type> first;
+	circular_deque_span<Type> second;
+
+	// O(1)
+	constexpr std::size_t size() const
+	{
+		return (this->first.size() + this->second.size());
+	}
+
+	// O(1)
+	constexpr bool empty() const
+	{
+		return this->first.empty();
+	}
+};
+
+
+// The index arithmetic shared by circular_deque and soa_circular_deque.
+//
+// Both keep their objects in a fixed array of capacity slots.
+// The back index is the free slot after the last object,
+// and the front index is the free slot before the first,
+// so the objects run from the slot after the front index up to the back index, wrapping around.
+template<std::size_t capacity>
+struct circular_deque_indices
+{
+	using size_type = std::size_t;
+
+	static constexpr size_type first_index = 0;
+	static constexpr size_type last_index = (capacity - 1);
+	static constexpr size_type initial_back_index = (capacity / 2);
+	static constexpr size_type initial_front_index = ((capacity / 2) - 1);
+
+	// Power of two capacities can wrap indices with a mask instead of a comparison
+	static constexpr bool power_of_two_capacity = ((capacity & (capacity - 1)) == 0);
+
+	static constexpr size_type index_after(size_type index, size_type distance)
+	{
+		return (index < (capacity - distance)) ? (index + distance) : (index + distance - capacity);
+	}
+
+	static constexpr size_type index_before(size_type index, size_type distance)
+	{
+		return (index >= distance) ? (index - distance) : (index + capacity - distance);
+	}
+
+	static constexpr size_type previous_back_index(size_type back_index)
+	{
+		return power_of_two_capacity ? ((back_index - 1) & last_index) : (back_index > first_index) ? (back_index - 1) : last_index;
+	}
+
+	static constexpr size_type next_back_index(size_type back_index)
+	{
+		return power_of_two_capacity ? ((back_index + 1) & last_index) : (back_index < last_index) ? (back_index + 1) : first_index;
+	}
+
+	static constexpr size_type previous_front_index(size_type front_index)
+	{
+		return power_of_two_capacity ? ((front_index + 1) & last_index) : (front_index < last_index) ? (front_index + 1) : first_index;
+	}
+
+	static constexpr size_type next_front_index(size_type front_index)
+	{
+		return power_of_two_capacity ? ((front_index - 1) & last_index) : (front_index > first_index) ? (front_index - 1) : last_index;
+	}
+};
+
+
+template<typename Type, std::size_t capacity, typename Statistics = circular_deque_no_statistics>
 class circular_deque;
 
-template<typename Type, std::size_t capacity>
+template<typename Type, std::size_t capacity, typename Statistics = circular_deque_no_statistics>
 class circular_deque_iterator;
 
 
-template<typename Type, std::size_t capacity_value>
-class circular_deque
+// Statistics is inherited privately,
+// so that an empty policy takes up no space
+template<typename Type, std::size_t capacity_value, typename Statistics>
+class circular_deque : private Statistics
 {
 public:
 	static_assert(capacity_value > 1, "Attempt to instantiate circular_deque with a capacity less than 2");
 
-	friend class circular_deque_iterator<Type, capacity_value>;
+	friend class circular_deque_iterator<Type, capacity_value, Statistics>;
+	friend class circular_deque_iterator<const Type, capacity_value, Statistics>;
 
 public:
 	using value_type = Type;
@@ -55,8 +392,11 @@ public:
 	using const_reference = const value_type &;
 	using pointer = value_type *;
 	using const_pointer = const value_type *;
-	using iterator = circular_deque_iterator<value_type, capacity_value>;
-	using const_iterator = circular_deque_iterator<const value_type, capacity_value>;
+	using iterator = circular_deque_iterator<value_type, capacity_value, Statistics>;
+	using const_iterator = circular_deque_iterator<const value_type, capacity_value, Statistics>;
+	using statistics_type = Statistics;
+	using spans = circular_deque_spans<value_type>;
+	using const_spans = circular_deque_spans<const value_type>;
 	using reverse_iterator = std::reverse_iterator<iterator>;
 	using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
@@ -64,36 +404,40 @@ public:
 	static constexpr size_type capacity = capacity_value;
 	
 private:
-	static constexpr size_type first_index = 0;
-	static constexpr size_type last_index = (capacity - 1);
-	static constexpr size_type initial_back_index = (capacity / 2);
-	static constexpr size_type initial_front_index = ((capacity / 2) - 1);
+	using indices = circular_deque_indices<capacity_value>;
+
+	static constexpr bool trivially_relocatable = circular_deque_is_trivially_relocatable<value_type>::value;
+
+	// The most bytes relocated through the stack at a time
+	static constexpr size_type relocation_buffer_size = 256;
+
+	using relocation_tag = std::integral_constant<bool, trivially_relocatable>;
 
 private:
 	size_type count = 0;
-	size_type back_index = initial_back_index;
-	size_type front_index = initial_front_index;
+	size_type back_index = indices::initial_back_index;
+	size_type front_index = indices::initial_front_index;
 	std::array<value_type, capacity_value> array {};
 
 private:
 	constexpr size_type previous_back_index() const
 	{
-		return previous_back_index(this->back_index);
+		return indices::previous_back_index(this->back_index);
 	}
 
 	constexpr size_type next_back_index() const
 	{
-		return next_back_index(this->back_index);
+		return indices::next_back_index(this->back_index);
 	}
 
 	constexpr size_type previous_front_index() const
 	{
-		return previous_front_index(this->front_index);
+		return indices::previous_front_index(this->front_index);
 	}
 
 	constexpr size_type next_front_index() const
 	{
-		return next_front_index(this->front_index);
+		return indices::next_front_index(this->front_index);
 	}
 
 	constexpr size_type begin_index() const
@@ -133,6 +477,12 @@ public:
 		return capacity;
 	}
 
+	// O(1)
+	constexpr const statistics_type & statistics() const
+	{
+		return *this;
+	}
+
 	// O(1)
 	pointer data()
 	{
@@ -173,6 +523,20 @@ public:
 		return this->array[this->previous_front_index()];
 	}
 
+	// O(1)
+	reference operator [](size_type offset)
+	{
+		assert(offset < this->size());
+		return this->array[this->offset_index(offset)];
+	}
+
+	// O(1)
+	constexpr const_reference operator [](size_type offset) const
+	{
+		assert(offset < this->size());
+		return this->array[this->offset_index(offset)];
+	}
+
 	// O(1)
 	iterator begin()
 	{
@@ -259,6 +623,12 @@ public:
 			
 		// Increase the object counter
 		++this->count;
+
+		// Record the push
+		this->statistics_policy().record_push_back(1, this->count);
+
+		if (this->full())
+			this->statistics_policy().record_full();
 	}
 
 	// O(1)
@@ -275,6 +645,12 @@ public:
 			
 		// Increase the object counter
 		++this->count;
+
+		// Record the push
+		this->statistics_policy().record_push_back(1, this->count);
+
+		if (this->full())
+			this->statistics_policy().record_full();
 	}
 	
 	// O(1)
@@ -291,6 +667,12 @@ public:
 			
 		// Increase the object counter
 		++this->count;
+
+		// Record the push
+		this->statistics_policy().record_push_front(1, this->count);
+
+		if (this->full())
+			this->statistics_policy().record_full();
 	}
 	
 	// O(1)
@@ -307,22 +689,90 @@ public:
 			
 		// Increase the object counter
 		++this->count;
+
+		// Record the push
+		this->statistics_policy().record_push_front(1, this->count);
+
+		if (this->full())
+			this->statistics_policy().record_full();
 	}
 	
+	// O(1)
+	// Returns false instead of pushing if the deque is full
+	bool try_push_back(const value_type & value)
+	{
+		if (this->full())
+		{
+			this->statistics_policy().record_rejected_push();
+			return false;
+		}
+
+		this->push_back(value);
+		return true;
+	}
+
+	// O(1)
+	// Returns false instead of pushing if the deque is full
+	bool try_push_back(value_type && value)
+	{
+		if (this->full())
+		{
+			this->statistics_policy().record_rejected_push();
+			return false;
+		}
+
+		this->push_back(std::move(value));
+		return true;
+	}
+
+	// O(1)
+	// Returns false instead of pushing if the deque is full
+	bool try_push_front(const value_type & value)
+	{
+		if (this->full())
+		{
+			this->statistics_policy().record_rejected_push();
+			return false;
+		}
+
+		this->push_front(value);
+		return true;
+	}
+
+	// O(1)
+	// Returns false instead of pushing if the deque is full
+	bool try_push_front(value_type && value)
+	{
+		if (this->full())
+		{
+			this->statistics_policy().record_rejected_push();
+			return false;
+		}
+
+		this->push_front(std::move(value));
+		return true;
+	}
+
 	// O(1)
 	void pop_back()
 	{
 		// Ensure the deque isn't empty
 		assert(!this->empty());
 		
-		// Destroy the object at the back
-		this->array[this->back_index].~value_type();
+		// Release the object at the back
+		this->release(this->previous_back_index());
 		
 		// Move the back index backwards
 		this->back_index = this->previous_back_index();
 		
 		// Decrease the object counter
 		--this->count;
+
+		// Record the pop
+		this->statistics_policy().record_pop_back(1, this->count);
+
+		if (this->empty())
+			this->statistics_policy().record_empty();
 	}
 	
 	// O(1)
@@ -331,48 +781,301 @@ public:
 		// Ensure the deque isn't empty
 		assert(!this->empty());
 		
-		// Destroy the object at the front
-		this->array[this->front_index].~value_type();
+		// Release the object at the front
+		this->release(this->begin_index());
 		
 		// Move the front index forwards
 		this->front_index = this->previous_front_index();
 		
 		// Decrease the object counter
 		--this->count;
+
+		// Record the pop
+		this->statistics_policy().record_pop_front(1, this->count);
+
+		if (this->empty())
+			this->statistics_policy().record_empty();
 	}
 	
-	// O(n)
-	void clear()
+	// O(n) in the number of objects removed
+	void pop_back(size_type amount)
 	{
-		// If the list isn't already clear
-		if (this->count > 0)
-		{
-			// If the front index is less than the back index
-			if (this->front_index < this->back_index)
-			{
-				// The array objects can be deleted linearly
-				for (size_type index = this->front_index; index < this->back_index; ++index)
-					this->array[index].~value_type();
-			}
-			// Otherwise, if the indices have swapped around
-			else
-			{
-				// Delete the objects at the front first
-				for (size_type index = this->front_index; index < capacity; ++index)
-					this->array[index].~value_type();
+		// Ensure the deque holds enough objects
+		assert(amount <= this->size());
+
+		// Release the objects at the back
+		this->destroy(this->count - amount, amount);
+
+		// Move the back index backwards in one step
+		this->back_index = indices::index_before(this->back_index, amount);
+
+		// Decrease the object counter
+		this->count -= amount;
+
+		// Record the pop
+		this->statistics_policy().record_pop_back(amount, this->count);
+
+		if ((amount > 0) && this->empty())
+			this->statistics_policy().record_empty();
+	}
+
+	// O(n) in the number of objects removed
+	void pop_front(size_type amount)
+	{
+		// Ensure the deque holds enough objects
+		assert(amount <= this->size());
+
+		// Release the objects at the front
+		this->destroy(0, amount);
+
+		// Move the front index forwards in one step
+		this->front_index = indices::index_after(this->front_index, amount);
+
+		// Decrease the object counter
+		this->count -= amount;
+
+		// Record the pop
+		this->statistics_policy().record_pop_front(amount, this->count);
+
+		if ((amount > 0) && this->empty())
+			this->statistics_policy().record_empty();
+	}
+
+	// O(1)
+	// Returns up to amount of the free slots after the back, without filling them.
+	// The slots hold stale objects which may be assigned to freely,
+	// then commit_back makes the first of them part of the deque.
+	// Any other modification of the deque discards the reservation.
+	spans reserve_back(size_type amount)
+	{
+		const size_type reserved = std::min(amount, (capacity - this->count));
+		const size_type first_run = std::min(reserved, (capacity - this->back_index));
+
+		pointer data = this->array.data();
+
+		return spans { { (data + this->back_index), first_run }, { data, (reserved - first_run) } };
+	}
+
+	// O(1)
+	// Appends the first amount slots of the last reservation to the back
+	void commit_back(size_type amount)
+	{
+		// Ensure the deque has room for them
+		assert(amount <= (this->max_size() - this->size()));
+
+		// Move the back index forwards in one step
+		this->back_index = indices::index_after(this->back_index, amount);
+
+		// Increase the object counter
+		this->count += amount;
+
+		// Record the push
+		this->statistics_policy().record_push_back(amount, this->count);
+
+		if ((amount > 0) && this->full())
+			this->statistics_policy().record_full();
+	}
+
+	// O(1)
+	// Returns up to amount objects from the front, without removing them
+	spans peek_front(size_type amount)
+	{
+		const size_type peeked = std::min(amount, this->count);
+		const size_type first = this->begin_index();
+		const size_type first_run = std::min(peeked, (capacity - first));
+
+		pointer data = this->array.data();
+
+		return spans { { (data + first), first_run }, { data, (peeked - first_run) } };
+	}
+
+	// O(1)
+	// Returns up to amount objects from the front, without removing them
+	const_spans peek_front(size_type amount) const
+	{
+		const size_type peeked = std::min(amount, this->count);
+		const size_type first = this->begin_index();
+		const size_type first_run = std::min(peeked, (capacity - first));
+
+		const_pointer data = this->array.data();
+
+		return const_spans { { (data + first), first_run }, { data, (peeked - first_run) } };
+	}
+
+	// O(n) in the number of objects removed
+	// Removes the first amount objects, typically after a peek_front
+	void consume_front(size_type amount)
+	{
+		this->pop_front(amount);
+	}
+
+	// O(n) in the distance to the nearer end
+	// Inserts value before position, moving whichever side is shorter.
+	// Returns an iterator referring to the inserted object.
+	iterator insert(iterator position, const value_type & value)
+	{
+		// Copy first, in case value is an object in this deque
+		return this->insert(position, value_type(value));
+	}
+
+	// O(n) in the distance to the nearer end
+	// Inserts value before position, moving whichever side is shorter.
+	// Returns an iterator referring to the inserted object.
+	iterator insert(iterator position, value_type && value)
+	{
+		// Ensure the deque isn't full
+		assert(!this->full());
+		assert(position.owner == this);
+
+		const size_type offset = position.count;
+
+		this->open_gap(offset, 1);
+		this->array[this->offset_index(offset)] = std::move(value);
+
+		return this->offset_iterator(offset);
+	}
+
+	// O(n) in the distance to the nearer end, plus the number of objects inserted
+	// Inserts amount copies of value before position, moving whichever side is shorter.
+	// Returns an iterator referring to the first inserted object.
+	iterator insert(iterator position, size_type amount, const value_type & value)
+	{
+		// Ensure the deque has room for them
+		assert(amount <= (this->max_size() - this->size()));
+		assert(position.owner == this);
+
+		// Copy first, in case value is an object in this deque
+		const value_type copy = value;
+		const size_type offset = position.count;
+
+		this->open_gap(offset, amount);
+
+		for (size_type index = 0; index < amount; ++index)
+			this->array[this->offset_index(offset + index)] = copy;
+
+		return this->offset_iterator(offset);
+	}
+
+	// O(n) in the distance to the nearer end, plus the number of objects inserted
+	// Inserts the objects in [first, last) before position, moving whichever side is shorter.
+	// Returns an iterator referring to the first inserted object.
+	// The range mustn't refer to this deque.
+	template<typename ForwardIterator, typename = typename std::enable_if<!std::is_integral<ForwardIterator>::value>::type>
+	iterator insert(iterator position, ForwardIterator first, ForwardIterator last)
+	{
+		assert(position.owner == this);
+
+		const size_type amount = static_cast<size_type>(std::distance(first, last));
+
+		// Ensure the deque has room for them
+		assert(amount <= (this->max_size() - this->size()));
+
+		const size_type offset = position.count;
+
+		this->open_gap(offset, amount);
+
+		for (size_type index = offset; first != last; ++first, ++index)
+			this->array[this->offset_index(index)] = *first;
+
+		return this->offset_iterator(offset);
+	}
+
+	// O(n) in the distance to the nearer end
+	// Removes the object at position, moving whichever side is shorter.
+	// Returns an iterator referring to the object after it.
+	iterator erase(iterator position)
+	{
+		// Ensure position refers to an object
+		assert(position.owner == this);
+		assert(position.count < this->size());
+
+		this->close_gap(position.count, 1);
+
+		return this->offset_iterator(position.count);
+	}
+
+	// O(n) in the distance to the nearer end, plus the number of objects removed
+	// Removes the objects in [first, last), moving whichever side is shorter.
+	// Returns an iterator referring to the object after them.
+	iterator erase(iterator first, iterator last)
+	{
+		assert((first.owner == this) && (last.owner == this));
+		assert((first.count <= last.count) && (last.count <= this->size()));
+
+		this->close_gap(first.count, (last.count - first.count));
+
+		return this->offset_iterator(first.count);
+	}
+
+	// O(n)
+	// Rearranges the underlying array so the objects are contiguous,
+	// with the front at the start of the array, and returns them.
+	// Free if they are contiguous already.
+	// Only the objects are moved, however large the array is.
+	circular_deque_span<value_type> linearize()
+	{
+		const size_type first = this->begin_index();
+
+		// If the objects don't wrap around the end of the array
+		if (first <= (capacity - this->count))
+			// They can be returned where they are
+			return circular_deque_span<value_type>(this->array.data() + first, this->count);
+
+		// Otherwise, the front run ends the array and the back run starts it
+		const size_type front_run = (capacity - first);
+		const size_type back_run = (this->count - front_run);
+		const size_type free_slots = (capacity - this->count);
+
+		// Close the free slots between the runs, leaving the back run first
+		if (free_slots > 0)
+			this->shift_forwards(first, front_run, free_slots);
+
+		// Then swap the two runs
+		this->rotate_left(back_run, this->count);
+
+		// And move the indices to match
+		this->front_index = indices::last_index;
+		this->back_index = (this->count < capacity) ? this->count : indices::first_index;
+
+		return circular_deque_span<value_type>(this->array.data(), this->count);
+	}
+
+	// O(n)
+	void clear()
+	{
+		// If the list isn't already clear
+		if (this->count > 0)
+		{
+			// If the first object's index is less than the back index
+			if (this->begin_index() < this->back_index)
+			{
+				// The array objects can be released linearly
+				for (size_type index = this->begin_index(); index < this->back_index; ++index)
+					this->release(index);
+			}
+			// Otherwise, if the indices have swapped around
+			else
+			{
+				// Release the objects at the front first
+				for (size_type index = this->begin_index(); index < capacity; ++index)
+					this->release(index);
 					
 				// Then the objects at the back
-				for (size_type index = first_index; index < this->back_index; ++index)
-					this->array[index].~value_type();
+				for (size_type index = indices::first_index; index < this->back_index; ++index)
+					this->release(index);
 			}
 			
+			// Record the clear
+			this->statistics_policy().record_clear(this->count);
+			this->statistics_policy().record_empty();
+
 			// Reset the object counter to zero
 			this->count = 0;
 		}
 
 		// Either way, return the indices to their optimal positions
-		this->back_index = initial_back_index;
-		this->front_index = initial_front_index;
+		this->back_index = indices::initial_back_index;
+		this->front_index = indices::initial_front_index;
 	}
 
 	// O(n)
@@ -385,11 +1088,11 @@ public:
 		if (this->empty())
 			return false;
 
-		// If the front index is less than the back index
-		if (this->front_index < this->back_index)
+		// If the first object's index is less than the back index
+		if (this->begin_index() < this->back_index)
 		{
 			// A linear search can be done
-			for (size_type index = this->front_index; index < this->back_index; ++index)
+			for (size_type index = this->begin_index(); index < this->back_index; ++index)
 				if (this->array[index] == value)
 					return true;
 					
@@ -399,12 +1102,12 @@ public:
 		else
 		{
 			// Search the front first
-			for (size_type index = this->front_index; index < capacity; ++index)
+			for (size_type index = this->begin_index(); index < capacity; ++index)
 				if (this->array[index] == value)
 					return true;
 			
 			// Then the back
-			for (size_type index = first_index; index < this->back_index; ++index)
+			for (size_type index = indices::first_index; index < this->back_index; ++index)
 				if (this->array[index] == value)
 					return true;
 					
@@ -412,64 +1115,519 @@ public:
 		}
 	}
 
+	// O(log n)
+	// Requires the deque to be sorted in ascending order
+	template<typename Key>
+	iterator lower_bound(const Key & key)
+	{
+		return this->lower_bound(key, std::less<>());
+	}
+
+	// O(log n)
+	// Requires the deque to be sorted in ascending order
+	template<typename Key>
+	const_iterator lower_bound(const Key & key) const
+	{
+		return this->lower_bound(key, std::less<>());
+	}
+
+	// O(log n)
+	// Requires the deque to be partitioned by compare(element, key)
+	template<typename Key, typename Compare>
+	iterator lower_bound(const Key & key, Compare compare)
+	{
+		return this->offset_iterator(this->lower_bound_offset(key, compare));
+	}
+
+	// O(log n)
+	// Requires the deque to be partitioned by compare(element, key)
+	template<typename Key, typename Compare>
+	const_iterator lower_bound(const Key & key, Compare compare) const
+	{
+		return this->offset_iterator(this->lower_bound_offset(key, compare));
+	}
+
+	// O(log n)
+	// Requires the deque to be sorted in ascending order
+	template<typename Key>
+	iterator upper_bound(const Key & key)
+	{
+		return this->upper_bound(key, std::less<>());
+	}
+
+	// O(log n)
+	// Requires the deque to be sorted in ascending order
+	template<typename Key>
+	const_iterator upper_bound(const Key & key) const
+	{
+		return this->upper_bound(key, std::less<>());
+	}
+
+	// O(log n)
+	// Requires the deque to be partitioned by !compare(key, element)
+	template<typename Key, typename Compare>
+	iterator upper_bound(const Key & key, Compare compare)
+	{
+		return this->offset_iterator(this->upper_bound_offset(key, compare));
+	}
+
+	// O(log n)
+	// Requires the deque to be partitioned by !compare(key, element)
+	template<typename Key, typename Compare>
+	const_iterator upper_bound(const Key & key, Compare compare) const
+	{
+		return this->offset_iterator(this->upper_bound_offset(key, compare));
+	}
+
+	// O(log n)
+	// Requires the deque to be sorted in ascending order
+	template<typename Key>
+	std::pair<iterator, iterator> equal_range(const Key & key)
+	{
+		return this->equal_range(key, std::less<>());
+	}
+
+	// O(log n)
+	// Requires the deque to be sorted in ascending order
+	template<typename Key>
+	std::pair<const_iterator, const_iterator> equal_range(const Key & key) const
+	{
+		return this->equal_range(key, std::less<>());
+	}
+
+	// O(log n)
+	// Requires the deque to be partitioned by both of the above
+	template<typename Key, typename Compare>
+	std::pair<iterator, iterator> equal_range(const Key & key, Compare compare)
+	{
+		return std::pair<iterator, iterator>(this->lower_bound(key, compare), this->upper_bound(key, compare));
+	}
+
+	// O(log n)
+	// Requires the deque to be partitioned by both of the above
+	template<typename Key, typename Compare>
+	std::pair<const_iterator, const_iterator> equal_range(const Key & key, Compare compare) const
+	{
+		return std::pair<const_iterator, const_iterator>(this->lower_bound(key, compare), this->upper_bound(key, compare));
+	}
+
 private:
-	static constexpr size_type previous_back_index(size_type back_index)
+	statistics_type & statistics_policy()
 	{
-		return (back_index > first_index) ? (back_index - 1) : last_index;
+		return *this;
 	}
 
-	static constexpr size_type next_back_index(size_type back_index)
+	// Makes an iterator referring to the object at offset from the front
+	iterator offset_iterator(size_type offset)
 	{
-		return (back_index < last_index) ? (back_index + 1) : first_index;
+		return iterator(*this, this->offset_index(offset), offset);
 	}
 
-	static constexpr size_type previous_front_index(size_type front_index)
+	// Makes a const_iterator referring to the object at offset from the front
+	const_iterator offset_iterator(size_type offset) const
 	{
-		return (front_index < last_index) ? (front_index + 1) : first_index;
+		return const_iterator(*this, this->offset_index(offset), offset);
 	}
 
-	static constexpr size_type next_front_index(size_type front_index)
+	template<typename Key, typename Compare>
+	size_type lower_bound_offset(const Key & key, Compare compare) const
+	{
+		const size_type first = this->begin_index();
+		const_pointer data = this->array.data();
+
+		// If the objects don't wrap around the end of the array
+		if (first <= (capacity - this->count))
+			// A single binary search can be done
+			return static_cast<size_type>(std::lower_bound(data + first, data + first + this->count, key, compare) - (data + first));
+
+		// Otherwise, the last object in the array ends the front run
+		const size_type front_count = (capacity - first);
+
+		// If the key isn't past it, the result lies in the front run
+		if (!compare(this->array[indices::last_index], key))
+			return static_cast<size_type>(std::lower_bound(data + first, data + capacity, key, compare) - (data + first));
+
+		// Otherwise, it lies in the back run
+		return front_count + static_cast<size_type>(std::lower_bound(data, data + (this->count - front_count), key, compare) - data);
+	}
+
+	template<typename Key, typename Compare>
+	size_type upper_bound_offset(const Key & key, Compare compare) const
+	{
+		const size_type first = this->begin_index();
+		const_pointer data = this->array.data();
+
+		// If the objects don't wrap around the end of the array
+		if (first <= (capacity - this->count))
+			// A single binary search can be done
+			return static_cast<size_type>(std::upper_bound(data + first, data + first + this->count, key, compare) - (data + first));
+
+		// Otherwise, the last object in the array ends the front run
+		const size_type front_count = (capacity - first);
+
+		// If the key is before it, the result lies in the front run
+		if (compare(key, this->array[indices::last_index]))
+			return static_cast<size_type>(std::upper_bound(data + first, data + capacity, key, compare) - (data + first));
+
+		// Otherwise, it lies in the back run
+		return front_count + static_cast<size_type>(std::upper_bound(data, data + (this->count - front_count), key, compare) - data);
+	}
+
+	// Converts an offset from the front into an index into the underlying array
+	constexpr size_type offset_index(size_type offset) const
+	{
+		return indices::index_after(this->begin_index(), offset);
+	}
+
+	// Releases amount objects, starting at offset from the front
+	void destroy(size_type offset, size_type amount)
+	{
+		// If there's nothing to release
+		if (amount == 0)
+			return;
+
+		const size_type first = this->offset_index(offset);
+
+		// If the objects don't wrap around the end of the array
+		if (first <= (capacity - amount))
+		{
+			// The array objects can be released linearly
+			for (size_type index = first; index < (first + amount); ++index)
+				this->release(index);
+		}
+		// Otherwise, if the objects wrap around
+		else
+		{
+			// Release the objects up to the end of the array first
+			for (size_type index = first; index < capacity; ++index)
+				this->release(index);
+
+			// Then the objects at the start of the array
+			for (size_type index = indices::first_index; index < (first + amount - capacity); ++index)
+				this->release(index);
+		}
+	}
+
+	// Makes room for amount objects at offset from the front,
+	// by moving the objects before offset towards the front of the array
+	// or the objects after it towards the back, whichever are fewer.
+	// The objects in the room are left to be assigned to.
+	void open_gap(size_type offset, size_type amount)
+	{
+		// If there's nothing to insert
+		if (amount == 0)
+			return;
+
+		// If there are fewer objects before offset
+		if (offset < (this->count - offset))
+		{
+			// Move them forwards
+			this->shift_forwards(this->begin_index(), offset, amount);
+			this->front_index = indices::index_before(this->front_index, amount);
+			this->count += amount;
+
+			this->statistics_policy().record_push_front(amount, this->count);
+		}
+		// Otherwise, move the objects after it backwards
+		else
+		{
+			this->shift_backwards(this->offset_index(offset), (this->count - offset), amount);
+			this->back_index = indices::index_after(this->back_index, amount);
+			this->count += amount;
+
+			this->statistics_policy().record_push_back(amount, this->count);
+		}
+
+		if (this->full())
+			this->statistics_policy().record_full();
+	}
+
+	// Removes amount objects at offset from the front,
+	// by moving the objects before them towards the back of the array
+	// or the objects after them towards the front, whichever are fewer
+	void close_gap(size_type offset, size_type amount)
+	{
+		// If there's nothing to remove
+		if (amount == 0)
+			return;
+
+		// Relocation doesn't release the objects it overwrites, so release them first
+		if (trivially_relocatable)
+			this->destroy(offset, amount);
+
+		// If there are fewer objects before the gap
+		if (offset < (this->count - offset - amount))
+		{
+			// Move them backwards
+			this->shift_backwards(this->begin_index(), offset, amount);
+
+			// Release the objects left behind at the front
+			if (!trivially_relocatable)
+				this->destroy(0, amount);
+
+			this->front_index = indices::index_after(this->front_index, amount);
+			this->count -= amount;
+
+			this->statistics_policy().record_pop_front(amount, this->count);
+		}
+		// Otherwise, move the objects after it forwards
+		else
+		{
+			this->shift_forwards(this->offset_index(offset + amount), (this->count - offset - amount), amount);
+
+			// Release the objects left behind at the back
+			if (!trivially_relocatable)
+				this->destroy(this->count - amount, amount);
+
+			this->back_index = indices::index_before(this->back_index, amount);
+			this->count -= amount;
+
+			this->statistics_policy().record_pop_back(amount, this->count);
+		}
+
+		if (this->empty())
+			this->statistics_policy().record_empty();
+	}
+
+	// Moves the amount objects starting at index distance slots towards the front of the array.
+	// The objects left behind are moved from, or value initialised if relocated.
+	void shift_forwards(size_type index, size_type amount, size_type distance)
+	{
+		this->shift_forwards(index, amount, distance, relocation_tag());
+	}
+
+	void shift_forwards(size_type index, size_type amount, size_type distance, std::false_type)
+	{
+		// Earliest first, so no object is overwritten before it moves
+		for (size_type source = index, target = indices::index_before(index, distance), remaining = amount; remaining > 0; --remaining)
+		{
+			this->array[target] = std::move(this->array[source]);
+			source = indices::next_back_index(source);
+			target = indices::next_back_index(target);
+		}
+	}
+
+	void shift_forwards(size_type index, size_type amount, size_type distance, std::true_type)
+	{
+		const size_type target = indices::index_before(index, distance);
+		const size_type overlap = std::min(amount, distance);
+
+		// End the lives of the objects about to be overwritten
+		this->destroy_objects(target, overlap);
+
+		// Copy the bytes in contiguous chunks, earliest first
+		for (size_type source_chunk = index, target_chunk = target, remaining = amount; remaining > 0;)
+		{
+			const size_type chunk = std::min(remaining, std::min((capacity - source_chunk), (capacity - target_chunk)));
+
+			std::memmove(static_cast<void *>(&this->array[target_chunk]), static_cast<const void *>(&this->array[source_chunk]), (chunk * sizeof(value_type)));
+
+			source_chunk = indices::index_after(source_chunk, chunk);
+			target_chunk = indices::index_after(target_chunk, chunk);
+			remaining -= chunk;
+		}
+
+		// Start new lives for the objects copied away from
+		this->construct_objects(indices::index_after(index, (amount - overlap)), overlap);
+	}
+
+	// Moves the amount objects starting at index distance slots towards the back of the array.
+	// The objects left behind are moved from, or value initialised if relocated.
+	void shift_backwards(size_type index, size_type amount, size_type distance)
+	{
+		this->shift_backwards(index, amount, distance, relocation_tag());
+	}
+
+	void shift_backwards(size_type index, size_type amount, size_type distance, std::false_type)
+	{
+		// Latest first, so no object is overwritten before it moves
+		for (size_type source = indices::index_after(index, amount), target = indices::index_after(index, (amount + distance)), remaining = amount; remaining > 0; --remaining)
+		{
+			source = indices::previous_back_index(source);
+			target = indices::previous_back_index(target);
+			this->array[target] = std::move(this->array[source]);
+		}
+	}
+
+	void shift_backwards(size_type index, size_type amount, size_type distance, std::true_type)
+	{
+		const size_type target = indices::index_after(index, distance);
+		const size_type overlap = std::min(amount, distance);
+
+		// End the lives of the objects about to be overwritten
+		this->destroy_objects(indices::index_after(target, (amount - overlap)), overlap);
+
+		// Copy the bytes in contiguous chunks, latest first.
+		// The chunk ends are kept in [1, capacity] so a chunk never wraps.
+		for (size_type source_end = indices::index_after(index, amount), target_end = indices::index_after(target, amount), remaining = amount; remaining > 0;)
+		{
+			source_end = (source_end == 0) ? capacity : source_end;
+			target_end = (target_end == 0) ? capacity : target_end;
+
+			const size_type chunk = std::min(remaining, std::min(source_end, target_end));
+
+			source_end -= chunk;
+			target_end -= chunk;
+			remaining -= chunk;
+
+			std::memmove(static_cast<void *>(&this->array[target_end]), static_cast<const void *>(&this->array[source_end]), (chunk * sizeof(value_type)));
+		}
+
+		// Start new lives for the objects copied away from
+		this->construct_objects(index, overlap);
+	}
+
+	// Ends the lives of amount objects starting at index, ahead of overwriting their bytes.
+	// Trivially copyable objects may be overwritten without this.
+	void destroy_objects(size_type index, size_type amount)
+	{
+		if (std::is_trivially_copyable<value_type>::value)
+			return;
+
+		for (; amount > 0; --amount, index = indices::next_back_index(index))
+			this->array[index].~value_type();
+	}
+
+	// Starts new lives for amount objects starting at index, whose bytes were relocated elsewhere
+	void construct_objects(size_type index, size_type amount)
+	{
+		if (std::is_trivially_copyable<value_type>::value)
+			return;
+
+		for (; amount > 0; --amount, index = indices::next_back_index(index))
+			::new (static_cast<void *>(&this->array[index])) value_type();
+	}
+
+	// Releases the resources held by the object at index.
+	//
+	// The underlying std::array owns every slot and destroys each one along with the deque,
+	// so every slot must hold a live object at all times.
+	// Destroying a removed object outright would leave a dead object there,
+	// to be assigned to by a later push and destroyed a second time by the array.
+	// So rather than being destroyed, the object is replaced by a value initialised one.
+	//
+	// This asks nothing more of Type than the deque already does:
+	// the array value initialises every slot when the deque is constructed,
+	// so Type must be default constructible in any case.
+	void release(size_type index)
+	{
+		this->release(index, std::is_trivially_destructible<value_type>());
+	}
+
+	// Trivially destructible objects hold nothing to release
+	void release(size_type, std::true_type)
+	{
+	}
+
+	void release(size_type index, std::false_type)
+	{
+		this->array[index] = value_type();
+	}
+
+	// Rotates the first length slots of the underlying array left by amount, with Gries and Mills' block swaps.
+	// Every slot is swapped about once, and no more than a fixed buffer is needed.
+	void rotate_left(size_type amount, size_type length)
+	{
+		// The lengths of the unfinished runs either side of the middle
+		const size_type middle = amount;
+		size_type left = amount;
+		size_type right = (length - amount);
+
+		if ((left == 0) || (right == 0))
+			return;
+
+		pointer data = this->array.data();
+
+		while (left != right)
+		{
+			// Swap the right run into place at the left, leaving a shorter left run
+			if (left > right)
+			{
+				swap_runs((data + middle - left), (data + middle), right, relocation_tag());
+				left -= right;
+			}
+			// Or swap the left run into place at the right, leaving a shorter right run
+			else
+			{
+				swap_runs((data + middle - left), (data + middle + right - left), left, relocation_tag());
+				right -= left;
+			}
+		}
+
+		swap_runs((data + middle - left), (data + middle), left, relocation_tag());
+	}
+
+	// Swaps two runs that don't overlap, byte by byte through a stack buffer
+	static void swap_runs(pointer first, pointer second, size_type amount, std::true_type)
 	{
-		return (front_index > first_index) ? (front_index - 1) : last_index;
+		unsigned char buffer[relocation_buffer_size];
+
+		unsigned char * first_bytes = reinterpret_cast<unsigned char *>(first);
+		unsigned char * second_bytes = reinterpret_cast<unsigned char *>(second);
+
+		for (size_type remaining = (amount * sizeof(value_type)); remaining > 0;)
+		{
+			const size_type bytes = (remaining < relocation_buffer_size) ? remaining : relocation_buffer_size;
+
+			std::memcpy(buffer, first_bytes, bytes);
+			std::memcpy(first_bytes, second_bytes, bytes);
+			std::memcpy(second_bytes, buffer, bytes);
+
+			first_bytes += bytes;
+			second_bytes += bytes;
+			remaining -= bytes;
+		}
+	}
+
+	// Swaps two runs that don't overlap, object by object
+	static void swap_runs(pointer first, pointer second, size_type amount, std::false_type)
+	{
+		std::swap_ranges(first, (first + amount), second);
 	}
 };
 
 
-template<typename Type, std::size_t capacity_value>
+// Type is const qualified for a const_iterator,
+// which refers to a const deque and only gives const access to its objects
+template<typename Type, std::size_t capacity_value, typename Statistics>
 class circular_deque_iterator
 {
 private:
-	friend class circular_deque<Type, capacity_value>;
+	friend class circular_deque<typename std::remove_const<Type>::type, capacity_value, Statistics>;
+
+	// So a const_iterator can be made from an iterator
+	friend class circular_deque_iterator<const Type, capacity_value, Statistics>;
 
 private:
-	using circular_deque_type = circular_deque<Type, capacity_value>;
+	using circular_deque_type = circular_deque<typename std::remove_const<Type>::type, capacity_value, Statistics>;
+	using owner_type = typename std::conditional<std::is_const<Type>::value, const circular_deque_type, circular_deque_type>::type;
 	using size_type = typename circular_deque_type::size_type;
 
 public:
 	using difference_type = typename circular_deque_type::difference_type;
-	using value_type = typename circular_deque_type::size_type;
-	using pointer = typename circular_deque_type::pointer;
-	using const_pointer = typename circular_deque_type::const_pointer;
-	using reference = typename circular_deque_type::reference;
-	using const_reference = typename circular_deque_type::const_reference;
+	using value_type = typename circular_deque_type::value_type;
+	using pointer = Type *;
+	using const_pointer = const Type *;
+	using reference = Type &;
+	using const_reference = const Type &;
 	using iterator_category = std::bidirectional_iterator_tag;
 
 private:
-	circular_deque_type * owner = nullptr;
+	owner_type * owner = nullptr;
 	size_type index = 0;
 	size_type count = 0;
 
-	explicit constexpr circular_deque_iterator(circular_deque_type & owner, size_type index, size_type count) :
+	explicit constexpr circular_deque_iterator(owner_type & owner, size_type index, size_type count) :
 		owner { &owner }, index { index }, count { count }
 	{
 	}
 
-	static constexpr circular_deque_iterator make_begin(circular_deque_type & owner)
+	static constexpr circular_deque_iterator make_begin(owner_type & owner)
 	{
 		return circular_deque_iterator(owner, owner.begin_index(), 0);
 	}
 
-	static constexpr circular_deque_iterator make_end(circular_deque_type & owner)
+	static constexpr circular_deque_iterator make_end(owner_type & owner)
 	{
 		return circular_deque_iterator(owner, owner.end_index(), owner.count);
 	}
@@ -478,29 +1636,27 @@ public:
 	// Must have a default constructor to meet the requirements of forward iterator
 	constexpr circular_deque_iterator() = default;
 
-	reference operator *()
+	// An iterator converts to a const_iterator, but not the other way around
+	template<typename Other, typename = typename std::enable_if<std::is_same<const Other, Type>::value && !std::is_same<Other, Type>::value>::type>
+	constexpr circular_deque_iterator(const circular_deque_iterator<Other, capacity_value, Statistics> & other) :
+		owner { other.owner }, index { other.index }, count { other.count }
 	{
-		return this->owner->array[this->index];
 	}
 
-	constexpr const_reference operator *() const
+	// The iterator being const doesn't make the object it refers to const
+	constexpr reference operator *() const
 	{
 		return this->owner->array[this->index];
 	}
 
-	pointer operator ->()
-	{
-		return &this->owner->array[this->index];
-	}
-
-	constexpr const_pointer operator ->() const
+	constexpr pointer operator ->() const
 	{
 		return &this->owner->array[this->index];
 	}
 
 	circular_deque_iterator & operator ++()
 	{
-		this->index = circular_deque_type::next_back_index(this->index);
+		this->index = circular_deque_indices<capacity_value>::next_back_index(this->index);
 		++this->count;
 		return *this;
 	}
@@ -514,7 +1670,7 @@ public:
 
 	circular_deque_iterator & operator --()
 	{
-		this->index = circular_deque_type::previous_back_index(this->index);
+		this->index = circular_deque_indices<capacity_value>::previous_back_index(this->index);
 		--this->count;
 		return *this;
 	}
@@ -536,4 +1692,52 @@ public:
 	{
 		return (this->count != other.count) || (this->index != other.index) || (this->owner != other.owner);
 	}
-};
\ No newline at end of file
+};
+
+
+// O(n)
+// Removes every object for which predicate returns true, keeping the rest in order.
+// The survivors are moved towards the front in a single pass over both runs,
+// then the objects left over at the back are released in one step.
+// Returns the number of objects removed.
+template<typename Type, std::size_t capacity, typename Statistics, typename Predicate>
+std::size_t erase_if(circular_deque<Type, capacity, Statistics> & deque, Predicate predicate)
+{
+	const auto runs = deque.peek_front(deque.size());
+
+	// Where the next survivor goes
+	Type * target = runs.first.begin();
+	Type * target_end = runs.first.end();
+	std::size_t kept = 0;
+
+	const auto keep = [&](Type & object)
+	{
+		// Once the first run is full, carry on into the second
+		if (target == target_end)
+		{
+			target = runs.second.begin();
+			target_end = runs.second.end();
+		}
+
+		// Survivors before the first removal stay where they are
+		if (target != &object)
+			*target = std::move(object);
+
+		++target;
+		++kept;
+	};
+
+	for (Type & object : runs.first)
+		if (!predicate(object))
+			keep(object);
+
+	for (Type & object : runs.second)
+		if (!predicate(object))
+			keep(object);
+
+	const std::size_t removed = (deque.size() - kept);
+
+	deque.pop_back(removed);
+
+	return removed;
+}
\ No newline at end of file
@@ -0,0 +1,317 @@
+#pragma once
+
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// Needs C++20 coroutines, the header is empty without them
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define CIRCULAR_DEQUE_HAS_COROUTINES 1
+#endif
+#endif
+
+#if defined(CIRCULAR_DEQUE_HAS_COROUTINES)
+
+// For std::size_t
+#include <cstddef>
+
+// For std::coroutine_handle
+#include <coroutine>
+
+// For std::move
+#include <utility>
+
+// For assert
+#include <cassert>
+
+// For circular_deque
+#include "circular_deque.h"
+
+
+// A bounded channel between coroutines, buffered by a circular_deque.
+//
+// co_await channel.send(value) suspends while the buffer is full,
+// co_await channel.receive() suspends while it is empty.
+// Whichever operation unblocks a waiting coroutine only queues it as ready,
+// then suspends itself behind it. The first coroutine to suspend runs the ready ones,
+// and any of those that suspend on the channel again return to it rather than nesting,
+// so no scheduler is needed and the stack doesn't grow with each hand over.
+// Waiters are woken in the order they started waiting,
+// and ready coroutines run in the order they became ready.
+//
+// Single threaded only: there are no atomics or locks,
+// every coroutine using a channel must run on the same thread.
+// Waiting costs no allocation, each waiter lives in its awaiting coroutine's frame.
+// The channel must outlive every coroutine waiting on it.
+template<typename Type, std::size_t capacity_value>
+class circular_deque_channel
+{
+public:
+	using deque_type = circular_deque<Type, capacity_value>;
+	using value_type = Type;
+	using size_type = std::size_t;
+
+public:
+	static constexpr size_type capacity = capacity_value;
+
+private:
+	// An intrusive, first in first out list node
+	struct waiter
+	{
+		std::coroutine_handle<> handle {};
+		waiter * next = nullptr;
+	};
+
+	struct waiter_list
+	{
+		waiter * head = nullptr;
+		waiter * tail = nullptr;
+
+		bool empty() const
+		{
+			return (this->head == nullptr);
+		}
+
+		void push(waiter & node)
+		{
+			node.next = nullptr;
+
+			if (this->tail != nullptr)
+				this->tail->next = &node;
+			else
+				this->head = &node;
+
+			this->tail = &node;
+		}
+
+		waiter & pop()
+		{
+			waiter & node = *this->head;
+
+			this->head = node.next;
+
+			if (this->head == nullptr)
+				this->tail = nullptr;
+
+			return node;
+		}
+	};
+
+public:
+	class send_awaiter : private waiter
+	{
+		friend class circular_deque_channel;
+
+	private:
+		circular_deque_channel * channel;
+		value_type value;
+		bool sent = false;
+
+	private:
+		send_awaiter(circular_deque_channel & channel, value_type && value) :
+			channel { &channel }, value { std::move(value) }
+		{
+		}
+
+	public:
+		// Only carries on without suspending if nobody is ready to run first,
+		// or if they will be run once this coroutine suspends
+		bool await_ready()
+		{
+			this->sent = this->channel->send_now(this->value);
+			return (this->sent && (this->channel->ready.empty() || this->channel->running));
+		}
+
+		void await_suspend(std::coroutine_handle<> handle)
+		{
+			this->handle = handle;
+			this->channel->suspend(*this, this->sent, this->channel->senders);
+		}
+
+		// The receiver that made room has already taken the value
+		void await_resume() const noexcept
+		{
+		}
+	};
+
+	class receive_awaiter : private waiter
+	{
+		friend class circular_deque_channel;
+
+	private:
+		circular_deque_channel * channel;
+		value_type value {};
+		bool received = false;
+
+	private:
+		explicit receive_awaiter(circular_deque_channel & channel) :
+			channel { &channel }
+		{
+		}
+
+	public:
+		// Only carries on without suspending if nobody is ready to run first,
+		// or if they will be run once this coroutine suspends
+		bool await_ready()
+		{
+			this->received = this->channel->receive_now(this->value);
+			return (this->received && (this->channel->ready.empty() || this->channel->running));
+		}
+
+		void await_suspend(std::coroutine_handle<> handle)
+		{
+			this->handle = handle;
+			this->channel->suspend(*this, this->received, this->channel->receivers);
+		}
+
+		// Either this coroutine took the value itself,
+		// or the sender that woke it left the value here
+		value_type await_resume()
+		{
+			return std::move(this->value);
+		}
+	};
+
+private:
+	deque_type deque {};
+	waiter_list senders;
+	waiter_list receivers;
+
+	// Woken coroutines, waiting for their turn to run
+	waiter_list ready;
+
+	// Whether a suspended coroutine is running the ready ones
+	bool running = false;
+
+public:
+	circular_deque_channel() = default;
+
+	circular_deque_channel(const circular_deque_channel &) = delete;
+	circular_deque_channel & operator =(const circular_deque_channel &) = delete;
+
+	~circular_deque_channel()
+	{
+		assert(this->senders.empty() && this->receivers.empty() && this->ready.empty());
+	}
+
+	// O(1)
+	constexpr bool empty() const
+	{
+		return this->deque.empty();
+	}
+
+	// O(1)
+	constexpr bool full() const
+	{
+		return this->deque.full();
+	}
+
+	// O(1)
+	// The number of buffered values
+	constexpr size_type size() const
+	{
+		return this->deque.size();
+	}
+
+	// O(1)
+	constexpr size_type max_size() const
+	{
+		return capacity;
+	}
+
+	// O(1)
+	send_awaiter send(const value_type & value)
+	{
+		return send_awaiter(*this, value_type(value));
+	}
+
+	// O(1)
+	send_awaiter send(value_type && value)
+	{
+		return send_awaiter(*this, std::move(value));
+	}
+
+	// O(1)
+	receive_awaiter receive()
+	{
+		return receive_awaiter(*this);
+	}
+
+private:
+	// Queues a suspending coroutine as ready if its operation is done,
+	// or as waiting if not, then runs the ready ones unless that is already happening.
+	// The suspending coroutine may itself be resumed, and even finish, before this returns.
+	void suspend(waiter & node, bool done, waiter_list & waiting)
+	{
+		if (done)
+			this->ready.push(node);
+		else
+			waiting.push(node);
+
+		if (this->running)
+			return;
+
+		this->running = true;
+
+		while (!this->ready.empty())
+			this->ready.pop().handle.resume();
+
+		this->running = false;
+	}
+
+	// O(1)
+	// Sends without suspending, returning false if the buffer is full
+	bool send_now(value_type & value)
+	{
+		// A waiting receiver means the buffer is empty, so skip it
+		if (!this->receivers.empty())
+		{
+			receive_awaiter & receiver = static_cast<receive_awaiter &>(this->receivers.pop());
+			receiver.value = std::move(value);
+			this->ready.push(receiver);
+			return true;
+		}
+
+		if (this->deque.full())
+			return false;
+
+		this->deque.push_back(std::move(value));
+		return true;
+	}
+
+	// O(1)
+	// Receives without suspending, returning false if the buffer is empty
+	bool receive_now(value_type & value)
+	{
+		if (this->deque.empty())
+			return false;
+
+		value = std::move(this->deque.front());
+		this->deque.pop_front();
+
+		// Refill the freed slot from the longest waiting sender
+		if (!this->senders.empty())
+		{
+			send_awaiter & sender = static_cast<send_awaiter &>(this->senders.pop());
+			this->deque.push_back(std::move(sender.value));
+			this->ready.push(sender);
+		}
+
+		return true;
+	}
+};
+
+#endif
@@ -0,0 +1,278 @@
+#pragma once
+
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// For std::size_t
+#include <cstddef>
+
+// For std::uintptr_t
+#include <cstdint>
+
+// For std::malloc, std::free, std::strtoull
+#include <cstdlib>
+
+// For std::unique_ptr
+#include <memory>
+
+// For std::forward
+#include <utility>
+
+// For std::bad_alloc
+#include <new>
+
+#if defined(__linux__)
+// For mmap, munmap, madvise, MAP_HUGETLB, MADV_HUGEPAGE
+#include <sys/mman.h>
+
+// For std::ifstream
+#include <fstream>
+
+// For std::string, std::getline
+#include <string>
+
+#define CIRCULAR_DEQUE_HAS_HUGE_PAGES 1
+#else
+#define CIRCULAR_DEQUE_HAS_HUGE_PAGES 0
+#endif
+
+
+// Backs large deques with huge pages, so their buffers need far fewer TLB entries.
+//
+// allocate_huge_pages tries, in order:
+//   1. explicit huge pages (MAP_HUGETLB), which need pages reserved in vm.nr_hugepages
+//   2. huge page aligned memory advised as transparent huge pages (MADV_HUGEPAGE)
+//   3. normal pages
+// and never fails for want of huge pages alone.
+//
+// A deque's buffer lives inside it, so backing the whole deque backs the buffer.
+// Round its capacity with huge_page_capacity so the whole deque fills whole huge pages,
+// measuring the room its own members take with any small instance of the same deque:
+//   constexpr std::size_t capture_overhead = huge_page_overhead<circular_deque<packet, 2>>();
+//   using capture_ring = circular_deque<packet, huge_page_capacity<packet>(1000000, capture_overhead)>;
+//   static_assert(fits_huge_pages<capture_ring>(), "capture_ring spills onto another huge page");
+//   auto ring = make_huge_page_unique<capture_ring>();
+
+// The usual huge page size on x86-64 and on AArch64 with 4 KiB pages
+constexpr std::size_t huge_page_size = (std::size_t(2) << 20);
+
+// The room a deque type takes besides its buffer:
+// its other members, and the padding its alignment may add at any capacity.
+// Deque is any instance of the deque type, whose capacity doesn't matter.
+template<typename Deque>
+constexpr std::size_t huge_page_overhead()
+{
+	return ((sizeof(Deque) - (Deque::capacity * sizeof(typename Deque::value_type))) + (alignof(Deque) - 1));
+}
+
+// The largest capacity for objects of Type, of at least requested,
+// whose buffer and overhead fit the same whole number of huge pages
+template<typename Type>
+constexpr std::size_t huge_page_capacity(std::size_t requested, std::size_t overhead, std::size_t page_size = huge_page_size)
+{
+	return (((((requested * sizeof(Type)) + overhead + page_size - 1) / page_size) * page_size) - overhead) / sizeof(Type);
+}
+
+// Whether a whole Deque fits the huge pages its buffer needs,
+// rather than its other members spilling onto one more
+template<typename Deque>
+constexpr bool fits_huge_pages(std::size_t page_size = huge_page_size)
+{
+	return (((sizeof(Deque) + page_size - 1) / page_size) == (((Deque::capacity * sizeof(typename Deque::value_type)) + page_size - 1) / page_size));
+}
+
+
+enum class huge_page_backing
+{
+	// Explicit huge pages, MAP_HUGETLB succeeded
+	explicit_huge_pages,
+
+	// Transparent huge pages were requested with madvise.
+	// The kernel may still use normal pages, see transparent_huge_page_bytes.
+	transparent_huge_pages,
+
+	normal_pages,
+};
+
+struct huge_page_memory
+{
+	void * address = nullptr;
+	std::size_t size = 0;
+	huge_page_backing backing = huge_page_backing::normal_pages;
+};
+
+
+// Allocates at least size bytes, rounded up to whole huge pages.
+// The result's address is nullptr if no memory could be had at all.
+inline huge_page_memory allocate_huge_pages(std::size_t size)
+{
+	huge_page_memory result;
+	result.size = (((size + huge_page_size - 1) / huge_page_size) * huge_page_size);
+
+#if CIRCULAR_DEQUE_HAS_HUGE_PAGES
+#if defined(MAP_HUGETLB)
+	// Explicit huge pages first
+	void * address = mmap(nullptr, result.size, (PROT_READ | PROT_WRITE), (MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB), -1, 0);
+
+	if (address != MAP_FAILED)
+	{
+		result.address = address;
+		result.backing = huge_page_backing::explicit_huge_pages;
+		return result;
+	}
+#endif
+
+	// Otherwise, map an extra huge page so the memory can be aligned to one
+	const std::size_t padded_size = (result.size + huge_page_size);
+	void * padded = mmap(nullptr, padded_size, (PROT_READ | PROT_WRITE), (MAP_PRIVATE | MAP_ANONYMOUS), -1, 0);
+
+	if (padded == MAP_FAILED)
+	{
+		result.size = 0;
+		return result;
+	}
+
+	const std::uintptr_t padded_start = reinterpret_cast<std::uintptr_t>(padded);
+	const std::uintptr_t start = (((padded_start + huge_page_size - 1) / huge_page_size) * huge_page_size);
+	const std::size_t head = static_cast<std::size_t>(start - padded_start);
+	const std::size_t tail = (padded_size - head - result.size);
+
+	// Return the unaligned ends
+	if (head > 0)
+		munmap(padded, head);
+
+	if (tail > 0)
+		munmap(reinterpret_cast<void *>(start + result.size), tail);
+
+	result.address = reinterpret_cast<void *>(start);
+
+#if defined(MADV_HUGEPAGE)
+	if (madvise(result.address, result.size, MADV_HUGEPAGE) == 0)
+		result.backing = huge_page_backing::transparent_huge_pages;
+#endif
+
+	return result;
+#else
+	result.address = std::malloc(result.size);
+
+	if (result.address == nullptr)
+		result.size = 0;
+
+	return result;
+#endif
+}
+
+inline void deallocate_huge_pages(const huge_page_memory & memory)
+{
+	if (memory.address == nullptr)
+		return;
+
+#if CIRCULAR_DEQUE_HAS_HUGE_PAGES
+	munmap(memory.address, memory.size);
+#else
+	std::free(memory.address);
+#endif
+}
+
+// How many bytes of the mapping holding address are currently backed by transparent huge pages,
+// according to /proc/self/smaps. Pages are only backed once touched.
+// Returns 0 if that can't be found out.
+inline std::size_t transparent_huge_page_bytes(const void * address)
+{
+#if CIRCULAR_DEQUE_HAS_HUGE_PAGES
+	std::ifstream smaps("/proc/self/smaps");
+
+	const std::uintptr_t target = reinterpret_cast<std::uintptr_t>(address);
+	const std::string field = "AnonHugePages:";
+
+	bool inside = false;
+
+	for (std::string line; std::getline(smaps, line);)
+	{
+		// A mapping's header starts with its hexadecimal address range
+		char * end = nullptr;
+		const unsigned long long begin = std::strtoull(line.c_str(), &end, 16);
+
+		if ((end != line.c_str()) && (*end == '-'))
+		{
+			const unsigned long long finish = std::strtoull(end + 1, nullptr, 16);
+
+			inside = ((target >= begin) && (target < finish));
+			continue;
+		}
+
+		if (inside && (line.compare(0, field.size(), field) == 0))
+			return static_cast<std::size_t>(std::strtoull(line.c_str() + field.size(), nullptr, 10) * 1024);
+	}
+#else
+	static_cast<void>(address);
+#endif
+
+	return 0;
+}
+
+
+template<typename Type>
+class huge_page_deleter
+{
+private:
+	huge_page_memory memory;
+
+public:
+	huge_page_deleter() = default;
+
+	explicit huge_page_deleter(const huge_page_memory & memory) :
+		memory { memory }
+	{
+	}
+
+	// How the object's memory is backed
+	huge_page_backing backing() const
+	{
+		return this->memory.backing;
+	}
+
+	void operator ()(Type * object) const
+	{
+		object->~Type();
+		deallocate_huge_pages(this->memory);
+	}
+};
+
+template<typename Type>
+using huge_page_unique_ptr = std::unique_ptr<Type, huge_page_deleter<Type>>;
+
+// Constructs a Type in memory backed by huge pages where possible.
+// get_deleter().backing() reports what was obtained.
+// Throws std::bad_alloc only if no memory could be had at all.
+template<typename Type, typename... Arguments>
+huge_page_unique_ptr<Type> make_huge_page_unique(Arguments && ... arguments)
+{
+	const huge_page_memory memory = allocate_huge_pages(sizeof(Type));
+
+	if (memory.address == nullptr)
+		throw std::bad_alloc();
+
+	try
+	{
+		return huge_page_unique_ptr<Type>(::new (memory.address) Type(std::forward<Arguments>(arguments)...), huge_page_deleter<Type>(memory));
+	}
+	catch (...)
+	{
+		deallocate_huge_pages(memory);
+		throw;
+	}
+}
@@ -0,0 +1,210 @@
+#pragma once
+
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// For std::size_t
+#include <cstddef>
+
+// For std::uint64_t
+#include <cstdint>
+
+// For std::array
+#include <array>
+
+// For std::numeric_limits
+#include <limits>
+
+
+// A fixed-size, HDR-style histogram of 64-bit values.
+//
+// Values below 2^precision_bits are counted exactly.
+// Above that, each power of two is split into 2^(precision_bits - 1) buckets,
+// so a recorded value is never off by more than 1 part in 2^(precision_bits - 1).
+// With the default of 7 bits that is under 1.6%, in 3776 counters.
+template<std::size_t precision_bits = 7>
+class latency_histogram
+{
+public:
+	static_assert((precision_bits > 1) && (precision_bits < 32), "Attempt to instantiate latency_histogram with an unsupported precision");
+
+public:
+	using value_type = std::uint64_t;
+	using size_type = std::size_t;
+	using count_type = std::uint64_t;
+
+private:
+	static constexpr size_type linear_count = (size_type(1) << precision_bits);
+	static constexpr size_type half_linear_count = (linear_count / 2);
+	static constexpr size_type magnitude_count = (64 - precision_bits);
+
+public:
+	static constexpr size_type bucket_count = (linear_count + (magnitude_count * half_linear_count));
+
+private:
+	std::array<count_type, bucket_count> counts {};
+	count_type total = 0;
+	value_type minimum = std::numeric_limits<value_type>::max();
+	value_type maximum = 0;
+	double sum = 0;
+
+public:
+	constexpr latency_histogram() = default;
+
+	// O(1)
+	constexpr bool empty() const
+	{
+		return (this->total == 0);
+	}
+
+	// O(1)
+	constexpr count_type count() const
+	{
+		return this->total;
+	}
+
+	// O(1)
+	constexpr value_type min() const
+	{
+		return this->empty() ? 0 : this->minimum;
+	}
+
+	// O(1)
+	constexpr value_type max() const
+	{
+		return this->maximum;
+	}
+
+	// O(1)
+	constexpr double mean() const
+	{
+		return this->empty() ? 0.0 : (this->sum / static_cast<double>(this->total));
+	}
+
+	// O(1)
+	void record(value_type value)
+	{
+		++this->counts[bucket_index(value)];
+		++this->total;
+		this->sum += static_cast<double>(value);
+
+		if (value < this->minimum)
+			this->minimum = value;
+
+		if (value > this->maximum)
+			this->maximum = value;
+	}
+
+	// O(n) in the number of buckets
+	// Returns the highest value equivalent to the recorded value at percentile,
+	// where percentile is in the range [0, 100]
+	value_type value_at_percentile(double percentile) const
+	{
+		if (this->empty())
+			return 0;
+
+		if (percentile >= 100.0)
+			return this->maximum;
+
+		// The number of values that must be at or below the result
+		count_type target = static_cast<count_type>(((percentile / 100.0) * static_cast<double>(this->total)) + 0.5);
+
+		if (target < 1)
+			target = 1;
+
+		count_type seen = 0;
+
+		for (size_type index = 0; index < bucket_count; ++index)
+		{
+			seen += this->counts[index];
+
+			if (seen >= target)
+			{
+				// Don't report past the largest value actually recorded
+				const value_type upper = bucket_upper(index);
+				return (upper < this->maximum) ? upper : this->maximum;
+			}
+		}
+
+		return this->maximum;
+	}
+
+	// O(n) in the number of buckets
+	void merge(const latency_histogram & other)
+	{
+		for (size_type index = 0; index < bucket_count; ++index)
+			this->counts[index] += other.counts[index];
+
+		this->total += other.total;
+		this->sum += other.sum;
+
+		if (other.minimum < this->minimum)
+			this->minimum = other.minimum;
+
+		if (other.maximum > this->maximum)
+			this->maximum = other.maximum;
+	}
+
+	// O(n) in the number of buckets
+	void clear()
+	{
+		*this = latency_histogram();
+	}
+
+private:
+	static size_type highest_bit(value_type value)
+	{
+#if defined(__GNUC__)
+		return static_cast<size_type>(63 - __builtin_clzll(value));
+#else
+		size_type result = 0;
+
+		while ((value >>= 1) != 0)
+			++result;
+
+		return result;
+#endif
+	}
+
+	static size_type bucket_index(value_type value)
+	{
+		// Small values are counted exactly
+		if (value < linear_count)
+			return static_cast<size_type>(value);
+
+		// Larger values keep only their top precision_bits - 1 bits below the leading one
+		const size_type shift = (highest_bit(value) - (precision_bits - 1));
+		const size_type mantissa = static_cast<size_type>(value >> shift);
+
+		return (linear_count + ((shift - 1) * half_linear_count) + (mantissa - half_linear_count));
+	}
+
+	static value_type bucket_upper(size_type index)
+	{
+		if (index < linear_count)
+			return static_cast<value_type>(index);
+
+		const size_type offset = (index - linear_count);
+		const size_type shift = ((offset / half_linear_count) + 1);
+		const value_type mantissa = static_cast<value_type>(half_linear_count + (offset % half_linear_count));
+
+		// The top bucket ends at the largest representable value
+		if (((shift + precision_bits) >= 64) && ((mantissa + 1) == linear_count))
+			return std::numeric_limits<value_type>::max();
+
+		return (((mantissa + 1) << shift) - 1);
+	}
+};
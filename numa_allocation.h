@@ -0,0 +1,241 @@
+#pragma once
+
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// For std::size_t
+#include <cstddef>
+
+// For std::uintptr_t
+#include <cstdint>
+
+// For std::malloc, std::free
+#include <cstdlib>
+
+// For std::unique_ptr
+#include <memory>
+
+// For std::forward
+#include <utility>
+
+// For std::bad_alloc
+#include <new>
+
+#if defined(__linux__)
+// For mmap, munmap
+#include <sys/mman.h>
+
+// For syscall, SYS_mbind, SYS_get_mempolicy, SYS_move_pages, sysconf
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// For ENOENT
+#include <cerrno>
+
+// For MPOL_PREFERRED, MPOL_F_NODE, MPOL_F_ADDR
+#include <linux/mempolicy.h>
+
+#define CIRCULAR_DEQUE_HAS_NUMA 1
+#else
+#define CIRCULAR_DEQUE_HAS_NUMA 0
+#endif
+
+
+// Places deques, or anything else, in memory on a chosen NUMA node.
+//
+// A deque's buffer lives inside it, so placing the whole deque places the buffer:
+//   auto queue = make_numa_unique<blocking_circular_deque<message, 4096>>(1);
+//
+// On Linux the memory is mapped separately and given a preferred node with mbind,
+// which the kernel follows whichever thread first touches each page.
+// No libnuma is needed. If the kernel refuses the policy (no NUMA support,
+// or a sandbox forbidding mbind) the memory is still returned, under the default policy,
+// and numa_node_of reports where it actually landed, page by page.
+// Elsewhere the memory comes from std::malloc and the node is ignored.
+
+// Requests no particular node
+constexpr int numa_any_node = -1;
+
+// Reported when an object's pages are spread over more than one node
+constexpr int numa_mixed_nodes = -2;
+
+// The highest node number the node hints can name
+constexpr int numa_max_node = 1023;
+
+// The size numa_allocate actually maps for a request of size bytes
+inline std::size_t numa_allocation_size(std::size_t size)
+{
+#if CIRCULAR_DEQUE_HAS_NUMA
+	const std::size_t page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+
+	return (((size + page_size - 1) / page_size) * page_size);
+#else
+	return size;
+#endif
+}
+
+// Allocates at least size bytes, preferably on node.
+// Returns nullptr if no memory could be had at all.
+inline void * numa_allocate(std::size_t size, int node)
+{
+#if CIRCULAR_DEQUE_HAS_NUMA
+	const std::size_t mapped_size = numa_allocation_size(size);
+
+	void * address = mmap(nullptr, mapped_size, (PROT_READ | PROT_WRITE), (MAP_PRIVATE | MAP_ANONYMOUS), -1, 0);
+
+	if (address == MAP_FAILED)
+		return nullptr;
+
+	if ((node >= 0) && (node <= numa_max_node))
+	{
+		constexpr std::size_t word_bits = (sizeof(unsigned long) * 8);
+		unsigned long mask[((numa_max_node + 1) + (word_bits - 1)) / word_bits] {};
+
+		mask[static_cast<std::size_t>(node) / word_bits] = (1UL << (static_cast<std::size_t>(node) % word_bits));
+
+		// Preferred rather than bound, so a full node spills over instead of failing.
+		// The kernel reads one bit fewer than it is told to.
+		// Failure leaves the default policy in place, which is the fallback.
+		syscall(SYS_mbind, address, mapped_size, MPOL_PREFERRED, mask, static_cast<unsigned long>(numa_max_node + 2), 0U);
+	}
+
+	return address;
+#else
+	static_cast<void>(node);
+	return std::malloc(size);
+#endif
+}
+
+// Frees memory from numa_allocate, given the size it was allocated with
+inline void numa_deallocate(void * address, std::size_t size)
+{
+	if (address == nullptr)
+		return;
+
+#if CIRCULAR_DEQUE_HAS_NUMA
+	munmap(address, numa_allocation_size(size));
+#else
+	static_cast<void>(size);
+	std::free(address);
+#endif
+}
+
+// The node holding the one page at address, faulting it in if need be,
+// or numa_any_node if that can't be found out.
+// Only samples that page, an object spanning several may be split across nodes;
+// check those with numa_node_of(address, size).
+inline int numa_node_of(const void * address)
+{
+#if CIRCULAR_DEQUE_HAS_NUMA
+	int node = numa_any_node;
+
+	if (syscall(SYS_get_mempolicy, &node, nullptr, 0UL, const_cast<void *>(address), static_cast<unsigned long>(MPOL_F_NODE | MPOL_F_ADDR)) != 0)
+		return numa_any_node;
+
+	return node;
+#else
+	static_cast<void>(address);
+	return numa_any_node;
+#endif
+}
+
+// The node holding every page of the size bytes at address,
+// numa_mixed_nodes if they are on different nodes,
+// or numa_any_node if that can't be found out.
+// Pages nobody has touched yet aren't on any node, so they are skipped,
+// and numa_any_node is also returned if none have been touched.
+inline int numa_node_of(const void * address, std::size_t size)
+{
+#if CIRCULAR_DEQUE_HAS_NUMA
+	const std::uintptr_t page_size = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+	const std::uintptr_t end = (reinterpret_cast<std::uintptr_t>(address) + size);
+
+	constexpr std::size_t batch_size = 64;
+	void * pages[batch_size];
+	int status[batch_size];
+
+	int result = numa_any_node;
+
+	for (std::uintptr_t page = (reinterpret_cast<std::uintptr_t>(address) & ~(page_size - 1)); page < end;)
+	{
+		std::size_t count = 0;
+
+		for (; (count < batch_size) && (page < end); ++count, page += page_size)
+			pages[count] = reinterpret_cast<void *>(page);
+
+		// Without target nodes move_pages moves nothing,
+		// and only reports the node of each page
+		if (syscall(SYS_move_pages, 0, static_cast<unsigned long>(count), pages, nullptr, status, 0) != 0)
+			return numa_any_node;
+
+		for (std::size_t index = 0; index < count; ++index)
+		{
+			if (status[index] == -ENOENT)
+				continue;
+
+			if (status[index] < 0)
+				return numa_any_node;
+
+			if (result == numa_any_node)
+				result = status[index];
+			else if (status[index] != result)
+				return numa_mixed_nodes;
+		}
+	}
+
+	return result;
+#else
+	static_cast<void>(address);
+	static_cast<void>(size);
+	return numa_any_node;
+#endif
+}
+
+
+template<typename Type>
+class numa_deleter
+{
+public:
+	void operator ()(Type * object) const
+	{
+		object->~Type();
+		numa_deallocate(object, sizeof(Type));
+	}
+};
+
+template<typename Type>
+using numa_unique_ptr = std::unique_ptr<Type, numa_deleter<Type>>;
+
+// Constructs a Type in memory on node, preferably.
+// Throws std::bad_alloc if no memory could be had at all.
+template<typename Type, typename... Arguments>
+numa_unique_ptr<Type> make_numa_unique(int node, Arguments && ... arguments)
+{
+	void * memory = numa_allocate(sizeof(Type), node);
+
+	if (memory == nullptr)
+		throw std::bad_alloc();
+
+	try
+	{
+		return numa_unique_ptr<Type>(::new (memory) Type(std::forward<Arguments>(arguments)...));
+	}
+	catch (...)
+	{
+		numa_deallocate(memory, sizeof(Type));
+		throw;
+	}
+}
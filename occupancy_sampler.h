@@ -0,0 +1,411 @@
+#pragma once
+
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// For std::size_t
+#include <cstddef>
+
+// For std::uint64_t
+#include <cstdint>
+
+// For std::array
+#include <array>
+
+// For std::atomic
+#include <atomic>
+
+// For std::ostream
+#include <ostream>
+
+// For std::declval
+#include <utility>
+
+// For std::enable_if, std::is_same
+#include <type_traits>
+
+// For std::strpbrk
+#include <cstring>
+
+// For std::assert
+#include <cassert>
+
+// For circular_deque, circular_deque_statistics
+#include "circular_deque.h"
+
+// For steady_clock_source
+#include "trace_clock.h"
+
+
+// A statistics policy that publishes a deque's size and operation counts through atomics,
+// so that an occupancy_sampler on another thread can read them without a data race.
+//
+// The counters are written with relaxed loads and stores rather than read-modify-writes,
+// so the writes must be serialised, as every modification of a circular_deque must be
+// (by a single owning thread, or by a mutex as in blocking_circular_deque).
+// Reads may come from any thread at any time, and are only a snapshot.
+// Objects removed by clear are counted as pops.
+class circular_deque_published_statistics
+{
+public:
+	using size_type = std::size_t;
+
+private:
+	std::atomic<size_type> size_value { 0 };
+	std::atomic<size_type> pushes { 0 };
+	std::atomic<size_type> pops { 0 };
+
+public:
+	// The size of the deque
+	size_type size() const
+	{
+		return this->size_value.load(std::memory_order_relaxed);
+	}
+
+	// The number of objects pushed onto either end
+	size_type push_count() const
+	{
+		return this->pushes.load(std::memory_order_relaxed);
+	}
+
+	// The number of objects popped from either end or removed by clear
+	size_type pop_count() const
+	{
+		return this->pops.load(std::memory_order_relaxed);
+	}
+
+public:
+	void record_push_back(size_type amount, size_type size)
+	{
+		this->record_push(amount, size);
+	}
+
+	void record_push_front(size_type amount, size_type size)
+	{
+		this->record_push(amount, size);
+	}
+
+	void record_pop_back(size_type amount, size_type size)
+	{
+		this->record_pop(amount, size);
+	}
+
+	void record_pop_front(size_type amount, size_type size)
+	{
+		this->record_pop(amount, size);
+	}
+
+	void record_clear(size_type amount)
+	{
+		this->record_pop(amount, 0);
+	}
+
+	void record_full() {}
+	void record_empty() {}
+	void record_rejected_push() {}
+
+private:
+	void record_push(size_type amount, size_type size)
+	{
+		this->pushes.store((this->pushes.load(std::memory_order_relaxed) + amount), std::memory_order_relaxed);
+		this->size_value.store(size, std::memory_order_relaxed);
+	}
+
+	void record_pop(size_type amount, size_type size)
+	{
+		this->pops.store((this->pops.load(std::memory_order_relaxed) + amount), std::memory_order_relaxed);
+		this->size_value.store(size, std::memory_order_relaxed);
+	}
+};
+
+
+// Records snapshots of the size and operation counts of registered deques
+// into a fixed buffer, for dumping as a Chrome trace or CSV afterwards.
+//
+// Deques can be registered in two ways:
+// * deques using circular_deque_published_statistics, and blocking_circular_deques using it,
+//   may be sampled from any thread, such as a monitoring thread watching a pipeline.
+// * deques using circular_deque_statistics are read directly,
+//   so they must only be sampled on the thread that owns them.
+//   Sampling one from another thread while it is modified is a data race.
+// Objects removed by clear are counted as pops.
+// Neither registering nor sampling allocates or locks,
+// once the buffer is full further samples are dropped and counted.
+// The sampler itself isn't thread safe, only one thread may sample at a time.
+template<std::size_t source_capacity_value, std::size_t sample_capacity_value, typename Clock = steady_clock_source>
+class occupancy_sampler
+{
+public:
+	using size_type = std::size_t;
+	using clock_type = Clock;
+	using tick_type = typename clock_type::tick_type;
+
+	struct sample
+	{
+		tick_type timestamp;
+		size_type source;
+		size_type size;
+		size_type pushes;
+		size_type pops;
+	};
+
+public:
+	static constexpr size_type source_capacity = source_capacity_value;
+	static constexpr size_type sample_capacity = sample_capacity_value;
+
+private:
+	struct source
+	{
+		const char * name;
+		const void * deque;
+		void (*read)(const void * deque, size_type & size, size_type & pushes, size_type & pops);
+	};
+
+private:
+	std::array<source, source_capacity_value> sources {};
+	std::array<sample, sample_capacity_value> samples {};
+	size_type source_count = 0;
+	size_type sample_count = 0;
+	size_type dropped_count = 0;
+
+public:
+	constexpr occupancy_sampler() = default;
+
+	// O(1)
+	constexpr size_type size() const
+	{
+		return this->sample_count;
+	}
+
+	// O(1)
+	// The number of samples that didn't fit in the buffer
+	constexpr size_type dropped() const
+	{
+		return this->dropped_count;
+	}
+
+	// O(1)
+	constexpr const sample & operator [](size_type index) const
+	{
+		return this->samples[index];
+	}
+
+	// O(1)
+	// Registers a deque that may only be sampled on the thread that owns it.
+	// The deque and the name must outlive the sampler.
+	// Returns the index used to identify the deque in the samples.
+	template<typename Type, std::size_t capacity>
+	size_type add(const char * name, const circular_deque<Type, capacity, circular_deque_statistics> & deque)
+	{
+		return this->add_source(name, &deque, &read_deque<Type, capacity>);
+	}
+
+	// O(1)
+	// Registers a deque that may be sampled from any thread.
+	// The deque and the name must outlive the sampler.
+	// Returns the index used to identify the deque in the samples.
+	template<typename Type, std::size_t capacity>
+	size_type add(const char * name, const circular_deque<Type, capacity, circular_deque_published_statistics> & deque)
+	{
+		return this->add(name, deque.statistics());
+	}
+
+	// O(1)
+	// Registers a blocking deque that may be sampled from any thread.
+	// The deque and the name must outlive the sampler.
+	// Returns the index used to identify the deque in the samples.
+	template<typename Deque, typename = typename std::enable_if<std::is_same<decltype(std::declval<const Deque &>().published_statistics()), const circular_deque_published_statistics &>::value>::type>
+	size_type add(const char * name, const Deque & deque)
+	{
+		return this->add(name, deque.published_statistics());
+	}
+
+	// O(1)
+	// Registers the published statistics of any deque, which may be sampled from any thread.
+	// The statistics and the name must outlive the sampler.
+	// Returns the index used to identify the deque in the samples.
+	size_type add(const char * name, const circular_deque_published_statistics & statistics)
+	{
+		return this->add_source(name, &statistics, &read_published);
+	}
+
+	// O(n) in the number of sources
+	// Takes one sample of every registered deque
+	void sample_all()
+	{
+		const tick_type timestamp = clock_type::now();
+
+		for (size_type index = 0; index < this->source_count; ++index)
+			this->sample_one(index, timestamp);
+	}
+
+	// O(1)
+	void sample_one(size_type index, tick_type timestamp)
+	{
+		// Ensure the source exists
+		assert(index < this->source_count);
+
+		if (this->sample_count == sample_capacity)
+		{
+			++this->dropped_count;
+			return;
+		}
+
+		const source & from = this->sources[index];
+
+		sample & to = this->samples[this->sample_count];
+		to.timestamp = timestamp;
+		to.source = index;
+		from.read(from.deque, to.size, to.pushes, to.pops);
+
+		++this->sample_count;
+	}
+
+	// O(1)
+	// Discards the samples, keeping the sources
+	void clear()
+	{
+		this->sample_count = 0;
+		this->dropped_count = 0;
+	}
+
+	// O(n)
+	// Writes the samples as comma separated values with a header row
+	void write_csv(std::ostream & stream) const
+	{
+		stream << "timestamp,deque,size,pushes,pops\n";
+
+		for (size_type index = 0; index < this->sample_count; ++index)
+		{
+			const sample & entry = this->samples[index];
+
+			stream << entry.timestamp << ',';
+			write_csv_field(stream, this->sources[entry.source].name);
+			stream << ',';
+			stream << entry.size << ',' << entry.pushes << ',' << entry.pops << '\n';
+		}
+	}
+
+	// O(n)
+	// Writes the samples as Chrome trace_event JSON counter events,
+	// one counter track per deque, loadable by chrome://tracing or Perfetto.
+	// Timestamps are converted to microseconds with ticks_per_microsecond.
+	void write_chrome_trace(std::ostream & stream, double ticks_per_microsecond = 1000.0) const
+	{
+		// Timestamps need fixed notation to keep their precision
+		const auto flags = stream.flags();
+		const auto precision = stream.precision();
+		stream.setf(std::ios_base::fixed, std::ios_base::floatfield);
+		stream.precision(3);
+
+		stream << "{\"traceEvents\":[";
+
+		for (size_type index = 0; index < this->sample_count; ++index)
+		{
+			const sample & entry = this->samples[index];
+
+			if (index > 0)
+				stream << ',';
+
+			stream << "\n{\"name\":\"";
+			write_escaped(stream, this->sources[entry.source].name);
+			stream << "\",\"ph\":\"C\",\"pid\":0,\"tid\":" << entry.source;
+			stream << ",\"ts\":" << (static_cast<double>(entry.timestamp) / ticks_per_microsecond);
+			stream << ",\"args\":{\"size\":" << entry.size << ",\"pushes\":" << entry.pushes << ",\"pops\":" << entry.pops << "}}";
+		}
+
+		stream << "\n]}\n";
+
+		stream.flags(flags);
+		stream.precision(precision);
+	}
+
+private:
+	size_type add_source(const char * name, const void * deque, decltype(source::read) read)
+	{
+		// Ensure there's room for another source
+		assert(this->source_count < source_capacity);
+
+		this->sources[this->source_count] = source { name, deque, read };
+
+		return this->source_count++;
+	}
+
+	template<typename Type, std::size_t capacity>
+	static void read_deque(const void * deque, size_type & size, size_type & pushes, size_type & pops)
+	{
+		const auto & typed = *static_cast<const circular_deque<Type, capacity, circular_deque_statistics> *>(deque);
+
+		size = typed.size();
+		pushes = typed.statistics().push_count();
+		pops = (typed.statistics().pop_count() + typed.statistics().clear_count());
+	}
+
+	static void read_published(const void * statistics, size_type & size, size_type & pushes, size_type & pops)
+	{
+		const auto & typed = *static_cast<const circular_deque_published_statistics *>(statistics);
+
+		size = typed.size();
+		pushes = typed.push_count();
+		pops = typed.pop_count();
+	}
+
+	// Quotes text if it holds a comma, quote or line break, doubling any quotes
+	static void write_csv_field(std::ostream & stream, const char * text)
+	{
+		if (std::strpbrk(text, ",\"\r\n") == nullptr)
+		{
+			stream << text;
+			return;
+		}
+
+		stream << '"';
+
+		for (; *text != '\0'; ++text)
+		{
+			if (*text == '"')
+				stream << '"';
+
+			stream << *text;
+		}
+
+		stream << '"';
+	}
+
+	// Escapes text for a JSON string, including every control character
+	static void write_escaped(std::ostream & stream, const char * text)
+	{
+		const char digits[] = "0123456789abcdef";
+
+		for (; *text != '\0'; ++text)
+		{
+			const unsigned char character = static_cast<unsigned char>(*text);
+
+			if ((character == '"') || (character == '\\'))
+				stream << '\\' << *text;
+			else if (character == '\n')
+				stream << "\\n";
+			else if (character == '\r')
+				stream << "\\r";
+			else if (character == '\t')
+				stream << "\\t";
+			else if (character < 0x20)
+				stream << "\\u00" << digits[character >> 4] << digits[character & 0xF];
+			else
+				stream << *text;
+		}
+	}
+};
@@ -0,0 +1,366 @@
+#pragma once
+
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// For std::size_t
+#include <cstddef>
+
+// For std::uint8_t, std::uint64_t
+#include <cstdint>
+
+// For std::array
+#include <array>
+
+// For std::ostream, std::istream
+#include <ostream>
+#include <istream>
+
+// For std::move
+#include <utility>
+
+// For circular_deque, circular_deque_no_statistics
+#include "circular_deque.h"
+
+// For steady_clock_source
+#include "trace_clock.h"
+
+
+// A compact binary trace of the operations performed on a deque.
+//
+// The trace begins with a header:
+//   4 bytes  magic "CDQT"
+//   1 byte   format version
+//   varint   size of the element type in bytes
+//   varint   capacity of the recorded deque
+// Followed by one record per operation:
+//   1 byte   operation
+//   varint   clock ticks since the previous record
+//   varint   size of the deque after the operation
+// Varints are unsigned LEB128, so a typical record takes 3 to 5 bytes.
+
+enum class trace_operation : std::uint8_t
+{
+	push_back,
+	push_front,
+	pop_back,
+	pop_front,
+	clear,
+};
+
+struct trace_header
+{
+	std::uint64_t element_size;
+	std::uint64_t capacity;
+};
+
+struct trace_record
+{
+	trace_operation operation;
+	std::uint64_t delta;
+	std::uint64_t size;
+};
+
+
+// Buffers records and writes them to a stream in blocks,
+// so recording an operation doesn't touch the stream
+class operation_trace_writer
+{
+public:
+	static constexpr std::uint8_t version = 1;
+
+private:
+	// Large enough for the longest record (1 + 10 + 10 bytes)
+	static constexpr std::size_t record_limit = 21;
+
+private:
+	std::ostream * stream;
+	std::array<unsigned char, 4096> buffer {};
+	std::size_t used = 0;
+
+public:
+	operation_trace_writer(std::ostream & stream, const trace_header & header) :
+		stream { &stream }
+	{
+		const char magic[] { 'C', 'D', 'Q', 'T' };
+		this->stream->write(magic, sizeof(magic));
+
+		this->buffer[this->used++] = version;
+		this->write_varint(header.element_size);
+		this->write_varint(header.capacity);
+	}
+
+	operation_trace_writer(const operation_trace_writer &) = delete;
+	operation_trace_writer & operator =(const operation_trace_writer &) = delete;
+
+	~operation_trace_writer()
+	{
+		this->flush();
+	}
+
+	// O(1)
+	void write(const trace_record & record)
+	{
+		if (this->used > (this->buffer.size() - record_limit))
+			this->flush();
+
+		this->buffer[this->used++] = static_cast<unsigned char>(record.operation);
+		this->write_varint(record.delta);
+		this->write_varint(record.size);
+	}
+
+	void flush()
+	{
+		this->stream->write(reinterpret_cast<const char *>(this->buffer.data()), static_cast<std::streamsize>(this->used));
+		this->used = 0;
+	}
+
+private:
+	void write_varint(std::uint64_t value)
+	{
+		while (value >= 0x80)
+		{
+			this->buffer[this->used++] = static_cast<unsigned char>((value & 0x7F) | 0x80);
+			value >>= 7;
+		}
+
+		this->buffer[this->used++] = static_cast<unsigned char>(value);
+	}
+};
+
+
+// Reads back a trace written by operation_trace_writer
+class operation_trace_reader
+{
+private:
+	std::istream * stream;
+	trace_header trace_information {};
+	bool valid = false;
+
+public:
+	explicit operation_trace_reader(std::istream & stream) :
+		stream { &stream }
+	{
+		char magic[4] {};
+		this->stream->read(magic, sizeof(magic));
+
+		if (!(*this->stream) || (magic[0] != 'C') || (magic[1] != 'D') || (magic[2] != 'Q') || (magic[3] != 'T'))
+			return;
+
+		if (this->stream->get() != operation_trace_writer::version)
+			return;
+
+		this->valid = (this->read_varint(this->trace_information.element_size) && this->read_varint(this->trace_information.capacity));
+	}
+
+	// False if the stream doesn't hold a trace this reader understands
+	bool good() const
+	{
+		return this->valid;
+	}
+
+	const trace_header & header() const
+	{
+		return this->trace_information;
+	}
+
+	// Returns false at the end of the trace
+	bool read(trace_record & record)
+	{
+		if (!this->valid)
+			return false;
+
+		const int operation = this->stream->get();
+
+		if ((operation < 0) || (operation > static_cast<int>(trace_operation::clear)))
+			return false;
+
+		record.operation = static_cast<trace_operation>(operation);
+
+		return (this->read_varint(record.delta) && this->read_varint(record.size));
+	}
+
+private:
+	bool read_varint(std::uint64_t & value)
+	{
+		value = 0;
+
+		for (unsigned shift = 0; shift < 64; shift += 7)
+		{
+			const int byte = this->stream->get();
+
+			if (byte < 0)
+				return false;
+
+			value |= (static_cast<std::uint64_t>(byte & 0x7F) << shift);
+
+			if ((byte & 0x80) == 0)
+				return true;
+		}
+
+		return false;
+	}
+};
+
+
+// A circular_deque that writes every operation performed on it to a trace
+template<typename Type, std::size_t capacity_value, typename Clock = steady_clock_source, typename Statistics = circular_deque_no_statistics>
+class recording_circular_deque
+{
+public:
+	using deque_type = circular_deque<Type, capacity_value, Statistics>;
+	using value_type = Type;
+	using size_type = std::size_t;
+	using reference = value_type &;
+	using const_reference = const value_type &;
+	using clock_type = Clock;
+	using tick_type = typename clock_type::tick_type;
+
+public:
+	static constexpr size_type capacity = capacity_value;
+
+private:
+	deque_type deque {};
+	operation_trace_writer writer;
+	tick_type previous;
+
+public:
+	// The stream must outlive the deque
+	explicit recording_circular_deque(std::ostream & stream) :
+		writer { stream, trace_header { sizeof(value_type), capacity_value } }, previous { clock_type::now() }
+	{
+	}
+
+	// O(1)
+	constexpr bool empty() const
+	{
+		return this->deque.empty();
+	}
+
+	// O(1)
+	constexpr bool full() const
+	{
+		return this->deque.full();
+	}
+
+	// O(1)
+	constexpr size_type size() const
+	{
+		return this->deque.size();
+	}
+
+	// O(1)
+	constexpr size_type max_size() const
+	{
+		return capacity;
+	}
+
+	// O(1)
+	// The recorded deque, for operations that aren't traced
+	constexpr const deque_type & underlying() const
+	{
+		return this->deque;
+	}
+
+	// O(1)
+	reference back()
+	{
+		return this->deque.back();
+	}
+
+	// O(1)
+	constexpr const_reference back() const
+	{
+		return this->deque.back();
+	}
+
+	// O(1)
+	reference front()
+	{
+		return this->deque.front();
+	}
+
+	// O(1)
+	constexpr const_reference front() const
+	{
+		return this->deque.front();
+	}
+
+	// O(1)
+	void push_back(const value_type & value)
+	{
+		this->deque.push_back(value);
+		this->record(trace_operation::push_back);
+	}
+
+	// O(1)
+	void push_back(value_type && value)
+	{
+		this->deque.push_back(std::move(value));
+		this->record(trace_operation::push_back);
+	}
+
+	// O(1)
+	void push_front(const value_type & value)
+	{
+		this->deque.push_front(value);
+		this->record(trace_operation::push_front);
+	}
+
+	// O(1)
+	void push_front(value_type && value)
+	{
+		this->deque.push_front(std::move(value));
+		this->record(trace_operation::push_front);
+	}
+
+	// O(1)
+	void pop_back()
+	{
+		this->deque.pop_back();
+		this->record(trace_operation::pop_back);
+	}
+
+	// O(1)
+	void pop_front()
+	{
+		this->deque.pop_front();
+		this->record(trace_operation::pop_front);
+	}
+
+	// O(n)
+	void clear()
+	{
+		this->deque.clear();
+		this->record(trace_operation::clear);
+	}
+
+	// Writes any buffered records to the stream
+	void flush()
+	{
+		this->writer.flush();
+	}
+
+private:
+	void record(trace_operation operation)
+	{
+		const tick_type now = clock_type::now();
+		const tick_type delta = (now > this->previous) ? (now - this->previous) : 0;
+
+		this->previous = now;
+		this->writer.write(trace_record { operation, static_cast<std::uint64_t>(delta), this->deque.size() });
+	}
+};
@@ -0,0 +1,153 @@
+#pragma once
+
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// For std::size_t
+#include <cstddef>
+
+// For std::assert
+#include <cassert>
+
+// For circular_deque
+#include "circular_deque.h"
+
+
+// Folds the last (up to) capacity_value pushed values with an associative operation.
+//
+// The operation does not need to be invertible or commutative,
+// only associative with the given identity,
+// e.g. max-with-index, gcd, bitwise or, matrix product.
+//
+// This is the 'two-stacks lite' algorithm,
+// which shares a single circular_deque between both stacks:
+// the oldest front_count values have been replaced by their suffix aggregates
+// (each holds the fold of itself and everything after it up to the boundary),
+// the rest are the raw values, whose fold is kept in back_aggregate.
+// When the front stack runs out, the whole deque is flipped in one backwards pass.
+template<typename Type, std::size_t capacity_value, typename Operation>
+class sliding_window_aggregate
+{
+public:
+	using value_type = Type;
+	using size_type = std::size_t;
+	using reference = value_type &;
+	using const_reference = const value_type &;
+	using operation_type = Operation;
+
+public:
+	static constexpr size_type capacity = capacity_value;
+
+private:
+	circular_deque<value_type, capacity_value> values {};
+	size_type front_count = 0;
+	value_type identity;
+	value_type back_aggregate;
+	operation_type operation;
+
+public:
+	explicit sliding_window_aggregate(const value_type & identity, const operation_type & operation = operation_type()) :
+		identity { identity }, back_aggregate { identity }, operation { operation }
+	{
+	}
+
+	// O(1)
+	constexpr bool empty() const
+	{
+		return this->values.empty();
+	}
+
+	// O(1)
+	constexpr bool full() const
+	{
+		return this->values.full();
+	}
+
+	// O(1)
+	constexpr size_type size() const
+	{
+		return this->values.size();
+	}
+
+	// O(1)
+	constexpr size_type max_size() const
+	{
+		return capacity;
+	}
+
+	// O(1)
+	// The fold of every value in the window, oldest first.
+	// An empty window yields the identity.
+	value_type query() const
+	{
+		return (this->front_count > 0) ? this->operation(this->values.front(), this->back_aggregate) : this->back_aggregate;
+	}
+
+	// O(1)
+	void push(const value_type & value)
+	{
+		// Ensure the window isn't full
+		assert(!this->full());
+
+		this->values.push_back(value);
+		this->back_aggregate = this->operation(this->back_aggregate, value);
+	}
+
+	// Amortised O(1), worst case O(n)
+	// Removes the oldest value from the window
+	void expire()
+	{
+		// Ensure the window isn't empty
+		assert(!this->empty());
+
+		// If the front stack has run out, every value is raw
+		if (this->front_count == 0)
+			this->flip();
+
+		this->values.pop_front();
+		--this->front_count;
+	}
+
+	// O(n)
+	void clear()
+	{
+		this->values.clear();
+		this->front_count = 0;
+		this->back_aggregate = this->identity;
+	}
+
+private:
+	// O(n)
+	// Replaces every raw value with its suffix aggregate
+	void flip()
+	{
+		value_type aggregate = this->identity;
+
+		auto iterator = this->values.end();
+		const auto begin = this->values.begin();
+
+		// Walk backwards, so each value folds in everything newer than it
+		while (iterator != begin)
+		{
+			--iterator;
+			aggregate = this->operation(*iterator, aggregate);
+			*iterator = aggregate;
+		}
+
+		this->front_count = this->values.size();
+		this->back_aggregate = this->identity;
+	}
+};
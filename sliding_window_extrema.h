@@ -0,0 +1,171 @@
+#pragma once
+
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// For std::size_t
+#include <cstddef>
+
+// For std::less
+#include <functional>
+
+// For std::assert
+#include <cassert>
+
+// For circular_deque
+#include "circular_deque.h"
+
+
+// Tracks the minimum and maximum of the last (up to) capacity_value pushed values.
+//
+// Each extreme is kept in a monotonic circular_deque:
+// values that can never become the extreme again are popped from the back,
+// values that have left the window are popped from the front.
+template<typename Type, std::size_t capacity_value, typename Compare = std::less<Type>>
+class sliding_window_extrema
+{
+public:
+	using value_type = Type;
+	using size_type = std::size_t;
+	using reference = value_type &;
+	using const_reference = const value_type &;
+	using value_compare = Compare;
+
+public:
+	static constexpr size_type capacity = capacity_value;
+
+private:
+	struct entry
+	{
+		// The push number of the value, used to detect expiry
+		size_type sequence;
+		value_type value;
+	};
+
+	using deque_type = circular_deque<entry, capacity_value>;
+
+private:
+	size_type push_count = 0;
+	size_type expire_count = 0;
+	deque_type minimum_deque {};
+	deque_type maximum_deque {};
+	value_compare compare {};
+
+public:
+	constexpr sliding_window_extrema() = default;
+
+	explicit constexpr sliding_window_extrema(const value_compare & compare) :
+		compare { compare }
+	{
+	}
+
+	// O(1)
+	constexpr bool empty() const
+	{
+		return (this->size() == 0);
+	}
+
+	// O(1)
+	constexpr bool full() const
+	{
+		return (this->size() == this->max_size());
+	}
+
+	// O(1)
+	constexpr size_type size() const
+	{
+		return (this->push_count - this->expire_count);
+	}
+
+	// O(1)
+	constexpr size_type max_size() const
+	{
+		return capacity;
+	}
+
+	// O(1)
+	constexpr value_compare value_comp() const
+	{
+		return this->compare;
+	}
+
+	// O(1)
+	constexpr const_reference min() const
+	{
+		assert(!this->empty());
+		return this->minimum_deque.front().value;
+	}
+
+	// O(1)
+	constexpr const_reference max() const
+	{
+		assert(!this->empty());
+		return this->maximum_deque.front().value;
+	}
+
+	// Amortised O(1)
+	void push(const value_type & value)
+	{
+		// Ensure the window isn't full
+		assert(!this->full());
+
+		// Drop every value that is no smaller than the new value,
+		// they can never be the minimum while the new value is in the window
+		while (!this->minimum_deque.empty() && !this->compare(this->minimum_deque.back().value, value))
+			this->minimum_deque.pop_back();
+
+		// Drop every value that is no larger than the new value,
+		// they can never be the maximum while the new value is in the window
+		while (!this->maximum_deque.empty() && !this->compare(value, this->maximum_deque.back().value))
+			this->maximum_deque.pop_back();
+
+		this->minimum_deque.push_back(entry { this->push_count, value });
+		this->maximum_deque.push_back(entry { this->push_count, value });
+
+		// Increase the push counter
+		++this->push_count;
+	}
+
+	// O(1)
+	// Removes the oldest value from the window
+	void expire()
+	{
+		// Ensure the window isn't empty
+		assert(!this->empty());
+
+		// If the oldest value is the current minimum, it leaves with it
+		if (this->minimum_deque.front().sequence == this->expire_count)
+			this->minimum_deque.pop_front();
+
+		// If the oldest value is the current maximum, it leaves with it
+		if (this->maximum_deque.front().sequence == this->expire_count)
+			this->maximum_deque.pop_front();
+
+		// Increase the expiry counter
+		++this->expire_count;
+	}
+
+	// O(n)
+	void clear()
+	{
+		this->minimum_deque.clear();
+		this->maximum_deque.clear();
+
+		// Return the counters to their initial values
+		this->push_count = 0;
+		this->expire_count = 0;
+	}
+};
@@ -0,0 +1,248 @@
+#pragma once
+
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// For std::size_t
+#include <cstddef>
+
+// For std::conditional, std::is_floating_point
+#include <type_traits>
+
+// For std::abs, std::sqrt
+#include <cmath>
+
+// For std::assert
+#include <cassert>
+
+// For circular_deque
+#include "circular_deque.h"
+
+
+// Keeps the sum, mean and variance of the last (up to) capacity_value pushed values.
+//
+// The running sums are updated on every push and expiry,
+// using Neumaier's compensated summation to bound the drift
+// that the repeated additions and subtractions would otherwise cause.
+template<typename Type, std::size_t capacity_value>
+class sliding_window_statistics
+{
+public:
+	using value_type = Type;
+	using size_type = std::size_t;
+	using reference = value_type &;
+	using const_reference = const value_type &;
+
+	// Floating point types are kept as they are, everything else is summed as double
+	using statistic_type = typename std::conditional<std::is_floating_point<value_type>::value, value_type, double>::type;
+
+public:
+	static constexpr size_type capacity = capacity_value;
+
+private:
+	class compensated_sum
+	{
+	private:
+		statistic_type sum = 0;
+		statistic_type compensation = 0;
+
+	public:
+		// O(1)
+		constexpr statistic_type value() const
+		{
+			return (this->sum + this->compensation);
+		}
+
+		// O(1)
+		void add(statistic_type value)
+		{
+			const statistic_type total = (this->sum + value);
+
+			// Recover the low-order bits lost by whichever operand was smaller
+			if (std::abs(this->sum) >= std::abs(value))
+				this->compensation += ((this->sum - total) + value);
+			else
+				this->compensation += ((value - total) + this->sum);
+
+			this->sum = total;
+		}
+
+		// O(1)
+		void clear()
+		{
+			this->sum = 0;
+			this->compensation = 0;
+		}
+	};
+
+private:
+	circular_deque<value_type, capacity_value> values {};
+
+	// Every value is offset by the first value of the window,
+	// which keeps the sum of squares from cancelling catastrophically
+	statistic_type shift = 0;
+	compensated_sum shifted_sum {};
+	compensated_sum shifted_square_sum {};
+
+public:
+	constexpr sliding_window_statistics() = default;
+
+	// O(1)
+	constexpr bool empty() const
+	{
+		return this->values.empty();
+	}
+
+	// O(1)
+	constexpr bool full() const
+	{
+		return this->values.full();
+	}
+
+	// O(1)
+	constexpr size_type size() const
+	{
+		return this->values.size();
+	}
+
+	// O(1)
+	constexpr size_type max_size() const
+	{
+		return capacity;
+	}
+
+	// O(1)
+	statistic_type sum() const
+	{
+		return ((this->shift * static_cast<statistic_type>(this->size())) + this->shifted_sum.value());
+	}
+
+	// O(1)
+	statistic_type mean() const
+	{
+		assert(!this->empty());
+		return (this->shift + (this->shifted_sum.value() / static_cast<statistic_type>(this->size())));
+	}
+
+	// O(1)
+	// Population variance
+	statistic_type variance() const
+	{
+		assert(!this->empty());
+		return (this->sum_of_squared_deviations() / static_cast<statistic_type>(this->size()));
+	}
+
+	// O(1)
+	// Bessel-corrected variance
+	statistic_type sample_variance() const
+	{
+		assert(this->size() > 1);
+		return (this->sum_of_squared_deviations() / static_cast<statistic_type>(this->size() - 1));
+	}
+
+	// O(1)
+	// Population standard deviation
+	statistic_type standard_deviation() const
+	{
+		return std::sqrt(this->variance());
+	}
+
+	// O(1)
+	void push(const value_type & value)
+	{
+		// Ensure the window isn't full
+		assert(!this->full());
+
+		// The first value of a window becomes the shift
+		if (this->values.empty())
+			this->shift = static_cast<statistic_type>(value);
+
+		this->values.push_back(value);
+		this->add(static_cast<statistic_type>(value) - this->shift);
+	}
+
+	// O(1)
+	// Removes the oldest value from the window
+	void expire()
+	{
+		// Ensure the window isn't empty
+		assert(!this->empty());
+
+		const statistic_type shifted = (static_cast<statistic_type>(this->values.front()) - this->shift);
+
+		this->values.pop_front();
+
+		// An empty window has exact sums, so drop whatever error has accumulated
+		if (this->values.empty())
+		{
+			this->shifted_sum.clear();
+			this->shifted_square_sum.clear();
+		}
+		else
+		{
+			this->subtract(shifted);
+		}
+	}
+
+	// O(n)
+	// Rebuilds the running sums from the values in the window.
+	// Only needed if the window is never emptied and
+	// the compensated drift still matters.
+	void recompute()
+	{
+		this->shifted_sum.clear();
+		this->shifted_square_sum.clear();
+
+		if (this->values.empty())
+			return;
+
+		this->shift = static_cast<statistic_type>(this->values.front());
+
+		for (auto iterator = this->values.begin(); iterator != this->values.end(); ++iterator)
+			this->add(static_cast<statistic_type>(*iterator) - this->shift);
+	}
+
+	// O(n)
+	void clear()
+	{
+		this->values.clear();
+		this->shifted_sum.clear();
+		this->shifted_square_sum.clear();
+		this->shift = 0;
+	}
+
+private:
+	void add(statistic_type shifted)
+	{
+		this->shifted_sum.add(shifted);
+		this->shifted_square_sum.add(shifted * shifted);
+	}
+
+	void subtract(statistic_type shifted)
+	{
+		this->shifted_sum.add(-shifted);
+		this->shifted_square_sum.add(-(shifted * shifted));
+	}
+
+	statistic_type sum_of_squared_deviations() const
+	{
+		const statistic_type sum = this->shifted_sum.value();
+		const statistic_type result = (this->shifted_square_sum.value() - ((sum * sum) / static_cast<statistic_type>(this->size())));
+
+		// Rounding can leave a tiny negative result for a constant window
+		return (result > 0) ? result : 0;
+	}
+};
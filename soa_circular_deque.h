@@ -0,0 +1,372 @@
+#pragma once
+
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// For std::size_t
+#include <cstddef>
+
+// For std::array
+#include <array>
+
+// For std::tuple, std::tuple_element, std::get
+#include <tuple>
+
+// For std::forward, std::index_sequence, std::index_sequence_for
+#include <utility>
+
+// For std::is_trivially_destructible, std::true_type, std::false_type
+#include <type_traits>
+
+// For std::min
+#include <algorithm>
+
+// For assert
+#include <cassert>
+
+// For circular_deque_spans, circular_deque_indices
+#include "circular_deque.h"
+
+
+// A circular deque of records, stored as a separate array per field.
+//
+// Every field shares one set of ring indices, so records are pushed and popped whole,
+// but a scan over one field with column<field>() only touches that field's array.
+// The layout matches circular_deque, and the index arithmetic is shared with it.
+template<std::size_t capacity_value, typename... Fields>
+class soa_circular_deque
+{
+public:
+	static_assert(capacity_value > 1, "Attempt to instantiate soa_circular_deque with a capacity less than 2");
+	static_assert(sizeof...(Fields) > 0, "Attempt to instantiate soa_circular_deque without any fields");
+
+public:
+	using value_type = std::tuple<Fields...>;
+	using size_type = std::size_t;
+	using reference = std::tuple<Fields &...>;
+	using const_reference = std::tuple<const Fields &...>;
+
+	template<std::size_t field>
+	using field_type = typename std::tuple_element<field, value_type>::type;
+
+	template<std::size_t field>
+	using column_spans = circular_deque_spans<field_type<field>>;
+
+	template<std::size_t field>
+	using const_column_spans = circular_deque_spans<const field_type<field>>;
+
+public:
+	static constexpr size_type capacity = capacity_value;
+	static constexpr size_type field_count = sizeof...(Fields);
+
+private:
+	using indices = circular_deque_indices<capacity_value>;
+
+	using fields = std::index_sequence_for<Fields...>;
+
+private:
+	size_type count = 0;
+	size_type back_index = indices::initial_back_index;
+	size_type front_index = indices::initial_front_index;
+	std::tuple<std::array<Fields, capacity_value>...> arrays {};
+
+private:
+	constexpr size_type begin_index() const
+	{
+		return indices::previous_front_index(this->front_index);
+	}
+
+public:
+	constexpr soa_circular_deque() = default;
+
+	// O(1)
+	constexpr bool empty() const
+	{
+		return (this->size() == 0);
+	}
+
+	// O(1)
+	constexpr bool full() const
+	{
+		return (this->size() == this->max_size());
+	}
+
+	// O(1)
+	constexpr size_type size() const
+	{
+		return this->count;
+	}
+
+	// O(1)
+	constexpr size_type max_size() const
+	{
+		return capacity;
+	}
+
+	// O(1)
+	reference back()
+	{
+		assert(!this->empty());
+		return this->make_reference(indices::previous_back_index(this->back_index), fields());
+	}
+
+	// O(1)
+	const_reference back() const
+	{
+		assert(!this->empty());
+		return this->make_reference(indices::previous_back_index(this->back_index), fields());
+	}
+
+	// O(1)
+	reference front()
+	{
+		assert(!this->empty());
+		return this->make_reference(this->begin_index(), fields());
+	}
+
+	// O(1)
+	const_reference front() const
+	{
+		assert(!this->empty());
+		return this->make_reference(this->begin_index(), fields());
+	}
+
+	// O(1)
+	reference operator [](size_type offset)
+	{
+		assert(offset < this->size());
+		return this->make_reference(this->offset_index(offset), fields());
+	}
+
+	// O(1)
+	const_reference operator [](size_type offset) const
+	{
+		assert(offset < this->size());
+		return this->make_reference(this->offset_index(offset), fields());
+	}
+
+	// O(1)
+	// The given field of the object at offset from the front
+	template<std::size_t field>
+	field_type<field> & get(size_type offset)
+	{
+		assert(offset < this->size());
+		return std::get<field>(this->arrays)[this->offset_index(offset)];
+	}
+
+	// O(1)
+	// The given field of the object at offset from the front
+	template<std::size_t field>
+	const field_type<field> & get(size_type offset) const
+	{
+		assert(offset < this->size());
+		return std::get<field>(this->arrays)[this->offset_index(offset)];
+	}
+
+	// O(1)
+	// Every object's value of the given field, front to back, as at most two contiguous runs
+	template<std::size_t field>
+	column_spans<field> column()
+	{
+		const size_type first = this->begin_index();
+		const size_type first_run = std::min(this->count, (capacity - first));
+
+		field_type<field> * data = std::get<field>(this->arrays).data();
+
+		return column_spans<field> { { (data + first), first_run }, { data, (this->count - first_run) } };
+	}
+
+	// O(1)
+	// Every object's value of the given field, front to back, as at most two contiguous runs
+	template<std::size_t field>
+	const_column_spans<field> column() const
+	{
+		const size_type first = this->begin_index();
+		const size_type first_run = std::min(this->count, (capacity - first));
+
+		const field_type<field> * data = std::get<field>(this->arrays).data();
+
+		return const_column_spans<field> { { (data + first), first_run }, { data, (this->count - first_run) } };
+	}
+
+	// O(1)
+	void push_back(const value_type & value)
+	{
+		// Ensure the deque isn't full
+		assert(!this->full());
+
+		// Copy each field into its array
+		this->assign(this->back_index, value, fields());
+
+		// Move the back index forwards
+		this->back_index = indices::next_back_index(this->back_index);
+
+		// Increase the object counter
+		++this->count;
+	}
+
+	// O(1)
+	void push_back(value_type && value)
+	{
+		// Ensure the deque isn't full
+		assert(!this->full());
+
+		// Move each field into its array
+		this->assign(this->back_index, std::move(value), fields());
+
+		// Move the back index forwards
+		this->back_index = indices::next_back_index(this->back_index);
+
+		// Increase the object counter
+		++this->count;
+	}
+
+	// O(1)
+	void push_front(const value_type & value)
+	{
+		// Ensure the deque isn't full
+		assert(!this->full());
+
+		// Copy each field into its array
+		this->assign(this->front_index, value, fields());
+
+		// Move the front index backwards
+		this->front_index = indices::next_front_index(this->front_index);
+
+		// Increase the object counter
+		++this->count;
+	}
+
+	// O(1)
+	void push_front(value_type && value)
+	{
+		// Ensure the deque isn't full
+		assert(!this->full());
+
+		// Move each field into its array
+		this->assign(this->front_index, std::move(value), fields());
+
+		// Move the front index backwards
+		this->front_index = indices::next_front_index(this->front_index);
+
+		// Increase the object counter
+		++this->count;
+	}
+
+	// O(1)
+	void pop_back()
+	{
+		// Ensure the deque isn't empty
+		assert(!this->empty());
+
+		// Move the back index backwards
+		this->back_index = indices::previous_back_index(this->back_index);
+
+		// Release the fields of the object at the back
+		this->release(this->back_index, fields());
+
+		// Decrease the object counter
+		--this->count;
+	}
+
+	// O(1)
+	void pop_front()
+	{
+		// Ensure the deque isn't empty
+		assert(!this->empty());
+
+		// Release the fields of the object at the front
+		this->release(this->begin_index(), fields());
+
+		// Move the front index forwards
+		this->front_index = indices::previous_front_index(this->front_index);
+
+		// Decrease the object counter
+		--this->count;
+	}
+
+	// O(n)
+	void clear()
+	{
+		// Release every object, front to back
+		for (size_type index = this->begin_index(), remaining = this->count; remaining > 0; --remaining)
+		{
+			this->release(index, fields());
+			index = indices::next_back_index(index);
+		}
+
+		// Reset the object counter to zero
+		this->count = 0;
+
+		// And return the indices to their optimal positions
+		this->back_index = indices::initial_back_index;
+		this->front_index = indices::initial_front_index;
+	}
+
+private:
+	template<std::size_t... field>
+	reference make_reference(size_type index, std::index_sequence<field...>)
+	{
+		return reference(std::get<field>(this->arrays)[index]...);
+	}
+
+	template<std::size_t... field>
+	const_reference make_reference(size_type index, std::index_sequence<field...>) const
+	{
+		return const_reference(std::get<field>(this->arrays)[index]...);
+	}
+
+	template<typename Tuple, std::size_t... field>
+	void assign(size_type index, Tuple && value, std::index_sequence<field...>)
+	{
+		// Each std::get only moves from its own field
+		const int expand[] { 0, ((std::get<field>(this->arrays)[index] = std::get<field>(std::forward<Tuple>(value))), 0)... };
+		static_cast<void>(expand);
+	}
+
+	// The arrays own every object, so rather than being destroyed
+	// each field is replaced by a value initialised one
+	template<std::size_t... field>
+	void release(size_type index, std::index_sequence<field...>)
+	{
+		const int expand[] { 0, (release_object(std::get<field>(this->arrays)[index]), 0)... };
+		static_cast<void>(expand);
+	}
+
+	template<typename Field>
+	static void release_object(Field & object)
+	{
+		release_object(object, std::is_trivially_destructible<Field>());
+	}
+
+	// Trivially destructible objects hold nothing to release
+	template<typename Field>
+	static void release_object(Field &, std::true_type)
+	{
+	}
+
+	template<typename Field>
+	static void release_object(Field & object, std::false_type)
+	{
+		object = Field();
+	}
+
+	// Converts an offset from the front into an index into the arrays
+	constexpr size_type offset_index(size_type offset) const
+	{
+		return indices::index_after(this->begin_index(), offset);
+	}
+};
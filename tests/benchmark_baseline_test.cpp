@@ -0,0 +1,206 @@
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+
+// Checks that benchmark baselines read back as written,
+// and that comparing against one fails exactly when it should.
+
+// For std::size_t
+#include <cstddef>
+
+// For std::remove
+#include <cstdio>
+
+// For std::string
+#include <string>
+
+// For std::vector
+#include <vector>
+
+// For std::stringstream, std::ostringstream
+#include <sstream>
+
+// For std::ofstream
+#include <fstream>
+
+// For std::cout, std::cerr
+#include <iostream>
+
+// For std::filesystem::temp_directory_path
+#include <filesystem>
+
+// For std::initializer_list
+#include <initializer_list>
+
+// For benchmark_runner, write_benchmark_baseline, read_benchmark_baseline
+#include "benchmarks/benchmark.h"
+
+// For test_runner, test_context
+#include "test.h"
+
+
+bool close_to(double value, double expected)
+{
+	const double difference = (value > expected) ? (value - expected) : (expected - value);
+	return (difference <= (expected * 1e-5));
+}
+
+void test_baseline_round_trip(test_context & context)
+{
+	const std::vector<benchmark_result> results
+	{
+		{ "push_back/64/circular_deque", 1, 1.25 },
+		{ "quoted \"name\" with a \\ backslash", 1, 0.001 },
+		{ "line\nbreak\ttab\rreturn", 1, 12345.6 },
+		{ std::string("control\x01\x1f" "characters"), 1, 7.0 },
+		{ "caf\xc3\xa9", 1, 3.5 },
+		{ "", 1, 2.0 },
+	};
+
+	std::stringstream stream;
+	write_benchmark_baseline(stream, results);
+
+	const std::string text = stream.str();
+
+	// JSON strings can't hold raw control characters
+	TEST_CHECK(context, text.find('\x01') == std::string::npos);
+	TEST_CHECK(context, text.find('\r') == std::string::npos);
+	TEST_CHECK(context, text.find("\\u0001\\u001f") != std::string::npos);
+
+	std::vector<baseline_entry> entries;
+
+	TEST_CHECK(context, read_benchmark_baseline(stream, entries));
+
+	if (!TEST_CHECK(context, entries.size() == results.size()))
+		return;
+
+	for (std::size_t index = 0; index < results.size(); ++index)
+	{
+		TEST_CHECK(context, entries[index].name == results[index].name);
+		TEST_CHECK(context, close_to(entries[index].nanoseconds_per_operation, results[index].nanoseconds_per_operation));
+	}
+
+	// A file with no results isn't a baseline
+	std::stringstream empty;
+	write_benchmark_baseline(empty, std::vector<benchmark_result>());
+
+	entries.clear();
+	TEST_CHECK(context, !read_benchmark_baseline(empty, entries));
+}
+
+struct timed_case
+{
+	const char * name;
+	double nanoseconds_per_operation;
+};
+
+// Writes baseline as a file, records current and returns what the comparison exits with
+int compare_runs(const std::vector<timed_case> & baseline, const std::vector<timed_case> & current, benchmark_options options)
+{
+	const std::string path = (std::filesystem::temp_directory_path() / "circular_deque_baseline_test.json").string();
+
+	{
+		std::vector<benchmark_result> results;
+
+		for (const timed_case & entry : baseline)
+			results.push_back(benchmark_result { entry.name, 1, entry.nanoseconds_per_operation });
+
+		std::ofstream file(path);
+		write_benchmark_baseline(file, results);
+	}
+
+	options.compare_baseline = path.c_str();
+
+	// Keep the runner's report out of the test output
+	std::ostringstream report;
+	std::streambuf * const previous_output = std::cout.rdbuf(report.rdbuf());
+	std::streambuf * const previous_errors = std::cerr.rdbuf(report.rdbuf());
+
+	benchmark_runner runner(options);
+
+	for (const timed_case & entry : current)
+		if (runner.selected(entry.name))
+			runner.record(benchmark_result { entry.name, 1, entry.nanoseconds_per_operation });
+
+	const int status = runner.finish();
+
+	std::cout.rdbuf(previous_output);
+	std::cerr.rdbuf(previous_errors);
+	std::remove(path.c_str());
+
+	return status;
+}
+
+void test_tolerance_decides_regressions(test_context & context)
+{
+	const std::vector<timed_case> baseline { { "fifo/small", 10.0 }, { "fifo/large", 100.0 }, { "round_trip/p99", 1000.0 } };
+
+	benchmark_options options;
+	options.tolerance = 0.10;
+
+	// Within the default tolerance, and faster
+	TEST_CHECK(context, compare_runs(baseline, { { "fifo/small", 10.9 }, { "fifo/large", 50.0 }, { "round_trip/p99", 1000.0 } }, options) == 0);
+
+	// One case past it
+	TEST_CHECK(context, compare_runs(baseline, { { "fifo/small", 11.2 }, { "fifo/large", 100.0 }, { "round_trip/p99", 1000.0 } }, options) == 1);
+
+	// An override loosens the cases it names, and no others
+	options.tolerances.emplace_back("round_trip", 0.5);
+
+	TEST_CHECK(context, compare_runs(baseline, { { "fifo/small", 10.0 }, { "fifo/large", 100.0 }, { "round_trip/p99", 1400.0 } }, options) == 0);
+	TEST_CHECK(context, compare_runs(baseline, { { "fifo/small", 10.0 }, { "fifo/large", 120.0 }, { "round_trip/p99", 1000.0 } }, options) == 1);
+
+	// The longest matching override wins, whichever order they were given in
+	options.tolerances.emplace_back("fifo", 0.5);
+	options.tolerances.emplace_back("fifo/large", 0.01);
+
+	TEST_CHECK(context, compare_runs(baseline, { { "fifo/small", 14.0 }, { "fifo/large", 100.5 }, { "round_trip/p99", 1000.0 } }, options) == 0);
+	TEST_CHECK(context, compare_runs(baseline, { { "fifo/small", 10.0 }, { "fifo/large", 102.0 }, { "round_trip/p99", 1000.0 } }, options) == 1);
+}
+
+void test_missing_cases_fail(test_context & context)
+{
+	const std::vector<timed_case> baseline { { "fifo/small", 10.0 }, { "fifo/large", 100.0 } };
+	const std::vector<timed_case> current { { "fifo/small", 10.0 }, { "fifo/large", 100.0 } };
+
+	benchmark_options options;
+
+	// A baseline case that the run didn't produce
+	TEST_CHECK(context, compare_runs(baseline, { { "fifo/small", 10.0 } }, options) == 1);
+
+	// Unless the filter left it out
+	options.filter = "small";
+	TEST_CHECK(context, compare_runs(baseline, current, options) == 0);
+
+	// A filter that selects nothing compares nothing
+	options.filter = "no such case";
+	TEST_CHECK(context, compare_runs(baseline, current, options) == 1);
+
+	// Nor does a baseline from another program
+	options.filter = nullptr;
+	TEST_CHECK(context, compare_runs({ { "other/program", 1.0 } }, current, options) == 1);
+}
+
+int main(int argc, char ** argv)
+{
+	test_runner runner(argc, argv);
+
+	runner.run("baseline_round_trip", test_baseline_round_trip);
+	runner.run("tolerance_decides_regressions", test_tolerance_decides_regressions);
+	runner.run("missing_cases_fail", test_missing_cases_fail);
+
+	return runner.finish();
+}
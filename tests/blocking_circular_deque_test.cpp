@@ -0,0 +1,314 @@
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// Checks blocking_circular_deque under each wait strategy:
+// every value is delivered exactly once and in order per producer,
+// and a blocked thread is woken by a single push or pop.
+
+// For std::size_t
+#include <cstddef>
+
+// For std::uint64_t
+#include <cstdint>
+
+// For std::vector
+#include <vector>
+
+// For std::thread, std::this_thread::sleep_for
+#include <thread>
+
+// For std::atomic
+#include <atomic>
+
+// For std::string
+#include <string>
+
+// For std::chrono::milliseconds, std::chrono::steady_clock
+#include <chrono>
+
+// For blocking_circular_deque and the wait strategies
+#include "blocking_circular_deque.h"
+
+// For test_runner, test_context
+#include "test.h"
+
+
+// A single core spends most of a spinning test waiting for the scheduler
+std::size_t scaled(std::size_t amount)
+{
+	return (std::thread::hardware_concurrency() > 1) ? amount : (amount / 8);
+}
+
+// Waits until flag is set, for at most a few seconds
+bool wait_for(const std::atomic<bool> & flag)
+{
+	const auto deadline = (std::chrono::steady_clock::now() + std::chrono::seconds(5));
+
+	while (!flag.load())
+	{
+		if (std::chrono::steady_clock::now() > deadline)
+			return false;
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	return true;
+}
+
+// Each value holds its producer in the high half and its sequence number in the low half
+constexpr std::uint64_t make_value(std::size_t producer, std::size_t sequence)
+{
+	return ((static_cast<std::uint64_t>(producer) << 32) | sequence);
+}
+
+template<typename WaitStrategy>
+void check_exactly_once(test_context & context, std::size_t producers, std::size_t consumers, std::size_t batch)
+{
+	blocking_circular_deque<std::uint64_t, 16, WaitStrategy> deque;
+
+	const std::size_t per_producer = scaled(4000);
+	const std::size_t total = (per_producer * producers);
+
+	// Every consumer takes its share, so all of them finish once every value is delivered
+	std::vector<std::size_t> shares(consumers, (total / consumers));
+	shares[0] += (total % consumers);
+
+	std::vector<std::atomic<unsigned>> seen(total);
+	std::atomic<std::uint64_t> checksum { 0 };
+	std::atomic<std::size_t> out_of_order { 0 };
+
+	std::vector<std::thread> threads;
+
+	for (std::size_t producer = 0; producer < producers; ++producer)
+	{
+		threads.emplace_back([&, producer]()
+		{
+			std::vector<std::uint64_t> values;
+
+			for (std::size_t sequence = 0; sequence < per_producer;)
+			{
+				if (batch == 1)
+				{
+					deque.push(make_value(producer, sequence));
+					++sequence;
+					continue;
+				}
+
+				values.clear();
+
+				for (std::size_t index = 0; (index < batch) && ((sequence + index) < per_producer); ++index)
+					values.push_back(make_value(producer, (sequence + index)));
+
+				const std::size_t pushed = deque.try_push(values.data(), values.size());
+
+				if (pushed == 0)
+					std::this_thread::yield();
+
+				sequence += pushed;
+			}
+		});
+	}
+
+	for (std::size_t consumer = 0; consumer < consumers; ++consumer)
+	{
+		threads.emplace_back([&, consumer]()
+		{
+			// The next sequence number this consumer may see from each producer
+			std::vector<std::size_t> next(producers, 0);
+			std::vector<std::uint64_t> values(batch);
+
+			const auto receive = [&](std::uint64_t value)
+			{
+				const std::size_t producer = static_cast<std::size_t>(value >> 32);
+				const std::size_t sequence = static_cast<std::size_t>(value & 0xFFFFFFFFu);
+
+				if ((producer >= producers) || (sequence >= per_producer))
+				{
+					out_of_order.fetch_add(1);
+					return;
+				}
+
+				// One producer's values come out in the order they went in
+				if (sequence < next[producer])
+					out_of_order.fetch_add(1);
+
+				next[producer] = (sequence + 1);
+
+				seen[(producer * per_producer) + sequence].fetch_add(1);
+				checksum.fetch_add(value);
+			};
+
+			for (std::size_t received = 0; received < shares[consumer];)
+			{
+				if (batch == 1)
+				{
+					receive(deque.pop());
+					++received;
+					continue;
+				}
+
+				const std::size_t wanted = ((shares[consumer] - received) < batch) ? (shares[consumer] - received) : batch;
+				const std::size_t popped = deque.try_pop(values.data(), wanted);
+
+				if (popped == 0)
+					std::this_thread::yield();
+
+				for (std::size_t index = 0; index < popped; ++index)
+					receive(values[index]);
+
+				received += popped;
+			}
+		});
+	}
+
+	for (auto & thread : threads)
+		thread.join();
+
+	std::uint64_t expected_checksum = 0;
+	std::size_t wrong_counts = 0;
+
+	for (std::size_t producer = 0; producer < producers; ++producer)
+	{
+		for (std::size_t sequence = 0; sequence < per_producer; ++sequence)
+		{
+			expected_checksum += make_value(producer, sequence);
+
+			if (seen[(producer * per_producer) + sequence].load() != 1)
+				++wrong_counts;
+		}
+	}
+
+	TEST_CHECK(context, wrong_counts == 0);
+	TEST_CHECK(context, out_of_order.load() == 0);
+	TEST_CHECK(context, checksum.load() == expected_checksum);
+	TEST_CHECK(context, deque.empty());
+}
+
+template<typename WaitStrategy>
+void check_wakes_blocked_threads(test_context & context)
+{
+	blocking_circular_deque<int, 4, WaitStrategy> deque;
+
+	// A consumer waiting on an empty deque
+	{
+		std::atomic<bool> woken { false };
+		int received = 0;
+
+		std::thread consumer([&]()
+		{
+			received = deque.pop();
+			woken.store(true);
+		});
+
+		// Give the consumer time to start waiting, and for the futex to park it
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		TEST_CHECK(context, !woken.load());
+
+		deque.push(42);
+
+		if (!TEST_CHECK(context, wait_for(woken)))
+			deque.push(0);
+
+		consumer.join();
+
+		TEST_CHECK(context, received == 42);
+	}
+
+	// A producer waiting on a full deque
+	{
+		for (int value = 0; value < 4; ++value)
+			deque.push(value);
+
+		std::atomic<bool> woken { false };
+
+		std::thread producer([&]()
+		{
+			deque.push(4);
+			woken.store(true);
+		});
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		TEST_CHECK(context, !woken.load());
+
+		TEST_CHECK(context, deque.pop() == 0);
+
+		if (!TEST_CHECK(context, wait_for(woken)))
+			deque.pop();
+
+		producer.join();
+
+		for (int value = 1; value <= 4; ++value)
+			TEST_CHECK(context, deque.pop() == value);
+
+		TEST_CHECK(context, deque.empty());
+	}
+}
+
+template<typename WaitStrategy>
+void register_strategy(test_runner & runner)
+{
+	const std::string name = WaitStrategy::name;
+
+	runner.run(("exactly_once_spsc/" + name).c_str(), [](test_context & context) { check_exactly_once<WaitStrategy>(context, 1, 1, 1); });
+	runner.run(("exactly_once_mpmc/" + name).c_str(), [](test_context & context) { check_exactly_once<WaitStrategy>(context, 3, 3, 1); });
+	runner.run(("exactly_once_mpmc_batches/" + name).c_str(), [](test_context & context) { check_exactly_once<WaitStrategy>(context, 3, 2, 5); });
+	runner.run(("wakes_blocked_threads/" + name).c_str(), [](test_context & context) { check_wakes_blocked_threads<WaitStrategy>(context); });
+}
+
+// Batches that run over the end of the array come back out in order
+void test_batches_across_the_wrap(test_context & context)
+{
+	blocking_circular_deque<int, 8, yield_wait_strategy> deque;
+
+	// Move the indices most of the way around
+	for (int value = 0; value < 6; ++value)
+		deque.push(value);
+
+	for (int value = 0; value < 6; ++value)
+		TEST_CHECK(context, deque.pop() == value);
+
+	const int values[] { 10, 11, 12, 13, 14, 15, 16, 17, 18, 19 };
+
+	// Only eight fit
+	TEST_CHECK(context, deque.try_push(values, 10) == 8);
+	TEST_CHECK(context, deque.full());
+	TEST_CHECK(context, deque.try_push(values, 1) == 0);
+
+	int popped[10] {};
+
+	TEST_CHECK(context, deque.try_pop(popped, 3) == 3);
+	TEST_CHECK(context, deque.try_push((values + 8), 2) == 2);
+	TEST_CHECK(context, deque.try_pop((popped + 3), 10) == 7);
+
+	for (int index = 0; index < 10; ++index)
+		TEST_CHECK(context, popped[index] == values[index]);
+
+	TEST_CHECK(context, deque.empty());
+	TEST_CHECK(context, deque.try_pop(popped, 1) == 0);
+}
+
+int main(int argc, char ** argv)
+{
+	test_runner runner(argc, argv);
+
+	register_strategy<spin_wait_strategy>(runner);
+	register_strategy<yield_wait_strategy>(runner);
+	register_strategy<futex_wait_strategy>(runner);
+
+	runner.run("batches_across_the_wrap", test_batches_across_the_wrap);
+
+	return runner.finish();
+}
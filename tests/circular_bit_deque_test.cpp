@@ -0,0 +1,218 @@
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// Checks circular_bit_deque against a std::deque<bool>,
+// including the word at a time pushes and queries.
+
+// For std::size_t, std::ptrdiff_t
+#include <cstddef>
+
+// For std::uint64_t
+#include <cstdint>
+
+// For std::deque
+#include <deque>
+
+// For std::count
+#include <algorithm>
+
+// For circular_bit_deque
+#include "circular_bit_deque.h"
+
+// For test_runner, test_context, test_random
+#include "test.h"
+
+
+template<typename Deque>
+bool same_flags(const Deque & deque, const std::deque<bool> & reference)
+{
+	if (deque.size() != reference.size())
+		return false;
+
+	for (std::size_t index = 0; index < reference.size(); ++index)
+		if (deque[index] != reference[index])
+			return false;
+
+	return true;
+}
+
+// The queries, worked out a flag at a time
+template<typename Deque>
+bool same_queries(const Deque & deque, const std::deque<bool> & reference, test_random & random)
+{
+	const std::size_t size = reference.size();
+
+	if (deque.count() != static_cast<std::size_t>(std::count(reference.begin(), reference.end(), true)))
+		return false;
+
+	std::size_t first = size;
+	std::size_t last = size;
+
+	for (std::size_t index = 0; index < size; ++index)
+	{
+		if (reference[index])
+		{
+			if (first == size)
+				first = index;
+
+			last = index;
+		}
+	}
+
+	if ((deque.find_first() != first) || (deque.find_last() != last))
+		return false;
+
+	// A random run of up to 64 flags
+	const std::size_t offset = random.below(size + 1);
+	const std::size_t available = (size - offset);
+	const std::size_t amount = random.below(((available < 64) ? available : 64) + 1);
+
+	std::uint64_t expected = 0;
+
+	for (std::size_t index = 0; index < amount; ++index)
+		if (reference[offset + index])
+			expected |= (std::uint64_t(1) << index);
+
+	return (deque.bits(offset, amount) == expected);
+}
+
+template<std::size_t capacity>
+void check_matches_std_deque(test_context & context)
+{
+	test_random random;
+
+	circular_bit_deque<capacity> deque;
+	std::deque<bool> reference;
+
+	for (int step = 0; step < 20000; ++step)
+	{
+		const std::size_t operation = random.below(9);
+		const bool value = (random.below(3) == 0);
+
+		const std::size_t free = (capacity - reference.size());
+
+		if ((operation == 0) && (free > 0))
+		{
+			deque.push_back(value);
+			reference.push_back(value);
+		}
+		else if ((operation == 1) && (free > 0))
+		{
+			deque.push_front(value);
+			reference.push_front(value);
+		}
+		else if ((operation == 2) && !reference.empty())
+		{
+			deque.pop_back();
+			reference.pop_back();
+		}
+		else if ((operation == 3) && !reference.empty())
+		{
+			deque.pop_front();
+			reference.pop_front();
+		}
+		else if (operation == 4)
+		{
+			const std::uint64_t word = random.next();
+			const std::size_t amount = random.below(((free < 64) ? free : 64) + 1);
+
+			deque.push_back(word, amount);
+
+			for (std::size_t index = 0; index < amount; ++index)
+				reference.push_back(((word >> index) & 1) != 0);
+		}
+		else if (operation == 5)
+		{
+			const std::uint64_t word = random.next();
+			const std::size_t amount = random.below(65);
+
+			deque.shift_in(word, amount);
+
+			for (std::size_t index = 0; index < amount; ++index)
+			{
+				if (reference.size() == capacity)
+					reference.pop_front();
+
+				reference.push_back(((word >> index) & 1) != 0);
+			}
+		}
+		else if (operation == 6)
+		{
+			const std::size_t amount = random.below(reference.size() + 1);
+
+			deque.pop_front(amount);
+			reference.erase(reference.begin(), (reference.begin() + static_cast<std::ptrdiff_t>(amount)));
+		}
+		else if (operation == 7)
+		{
+			const std::size_t amount = random.below(reference.size() + 1);
+
+			deque.pop_back(amount);
+			reference.erase((reference.end() - static_cast<std::ptrdiff_t>(amount)), reference.end());
+		}
+		else if ((operation == 8) && !reference.empty())
+		{
+			const std::size_t offset = random.below(reference.size());
+
+			deque.set(offset, value);
+			reference[offset] = value;
+		}
+
+		if (!TEST_CHECK(context, same_flags(deque, reference)))
+			return;
+
+		if (!TEST_CHECK(context, same_queries(deque, reference, random)))
+			return;
+	}
+}
+
+void test_one_word_matches_std_deque(test_context & context)
+{
+	check_matches_std_deque<64>(context);
+}
+
+void test_several_words_match_std_deque(test_context & context)
+{
+	check_matches_std_deque<192>(context);
+}
+
+void test_finds_nothing_when_clear(test_context & context)
+{
+	circular_bit_deque<128> deque;
+
+	deque.push_back(0, 64);
+	deque.push_back(0, 40);
+
+	TEST_CHECK(context, deque.count() == 0);
+	TEST_CHECK(context, deque.find_first() == deque.size());
+	TEST_CHECK(context, deque.find_last() == deque.size());
+
+	deque.clear();
+
+	TEST_CHECK(context, deque.empty());
+	TEST_CHECK(context, deque.find_first() == 0);
+}
+
+int main(int argc, char ** argv)
+{
+	test_runner runner(argc, argv);
+
+	runner.run("one_word_matches_std_deque", test_one_word_matches_std_deque);
+	runner.run("several_words_match_std_deque", test_several_words_match_std_deque);
+	runner.run("finds_nothing_when_clear", test_finds_nothing_when_clear);
+
+	return runner.finish();
+}
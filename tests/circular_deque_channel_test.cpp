@@ -0,0 +1,188 @@
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// Checks circular_deque_channel hands values over in order,
+// and wakes its waiters without nesting a stack frame for each hand over.
+
+// For std::size_t
+#include <cstddef>
+
+// For std::suspend_never
+#include <coroutine>
+
+// For std::exception
+#include <exception>
+
+// For std::vector
+#include <vector>
+
+// For std::string
+#include <string>
+
+// For circular_deque_channel
+#include "circular_deque_channel.h"
+
+// For test_runner, test_context
+#include "test.h"
+
+
+// A coroutine that starts straight away and frees itself when it finishes
+struct detached
+{
+	struct promise_type
+	{
+		detached get_return_object() { return {}; }
+		std::suspend_never initial_suspend() noexcept { return {}; }
+		std::suspend_never final_suspend() noexcept { return {}; }
+		void return_void() {}
+		void unhandled_exception() { std::terminate(); }
+	};
+};
+
+template<typename Channel>
+detached produce(Channel & channel, int first, int count, std::vector<std::string> & log)
+{
+	for (int value = first; value < (first + count); ++value)
+	{
+		log.push_back("send " + std::to_string(value));
+		co_await channel.send(value);
+		log.push_back("sent " + std::to_string(value));
+	}
+}
+
+// Where consume notes each value it receives, if anywhere
+std::vector<std::string> * channel_log = nullptr;
+
+template<typename Channel>
+detached consume(Channel & channel, int count, std::vector<int> & received, bool & finished)
+{
+	for (int index = 0; index < count; ++index)
+	{
+		received.push_back(co_await channel.receive());
+
+		if (channel_log != nullptr)
+			channel_log->push_back("received");
+	}
+
+	finished = true;
+}
+
+
+void test_values_arrive_in_order(test_context & context)
+{
+	circular_deque_channel<int, 4> channel;
+
+	std::vector<int> received;
+	std::vector<std::string> log;
+	bool finished = false;
+
+	consume(channel, 1000, received, finished);
+	produce(channel, 0, 1000, log);
+
+	TEST_CHECK(context, finished);
+	TEST_CHECK(context, received.size() == 1000);
+
+	for (std::size_t index = 0; index < received.size(); ++index)
+		TEST_CHECK(context, received[index] == static_cast<int>(index));
+
+	TEST_CHECK(context, channel.empty());
+}
+
+// A long hand over chain must not nest a stack frame per value
+void test_many_hand_overs(test_context & context)
+{
+	circular_deque_channel<int, 2> channel;
+
+	std::vector<int> received;
+	std::vector<std::string> log;
+	bool finished = false;
+
+	constexpr int count = 200000;
+
+	consume(channel, count, received, finished);
+	produce(channel, 0, count, log);
+
+	TEST_CHECK(context, finished);
+	TEST_CHECK(context, received.size() == static_cast<std::size_t>(count));
+	TEST_CHECK(context, (received.size() == static_cast<std::size_t>(count)) && (received.back() == (count - 1)));
+}
+
+// The sender carries on only after the receiver it woke has run
+void test_wakes_receiver_before_sender_continues(test_context & context)
+{
+	circular_deque_channel<int, 2> channel;
+
+	std::vector<int> received;
+	std::vector<std::string> log;
+	bool finished = false;
+
+	consume(channel, 1, received, finished);
+
+	TEST_CHECK(context, received.empty());
+
+	// The receiver finishes before the sender carries on
+	channel_log = &log;
+	produce(channel, 7, 1, log);
+	channel_log = nullptr;
+
+	TEST_CHECK(context, finished);
+	TEST_CHECK(context, (received.size() == 1) && (received[0] == 7));
+
+	const std::vector<std::string> expected { "send 7", "received", "sent 7" };
+
+	TEST_CHECK(context, log == expected);
+}
+
+// Senders blocked on a full buffer get in, and are woken, in the order they waited
+void test_senders_wake_in_order(test_context & context)
+{
+	circular_deque_channel<int, 2> channel;
+
+	std::vector<std::string> log;
+
+	produce(channel, 0, 2, log);
+	produce(channel, 10, 1, log);
+	produce(channel, 20, 1, log);
+
+	TEST_CHECK(context, channel.full());
+
+	std::vector<int> received;
+	bool finished = false;
+
+	consume(channel, 4, received, finished);
+
+	TEST_CHECK(context, finished);
+	TEST_CHECK(context, (received == std::vector<int> { 0, 1, 10, 20 }));
+
+	const std::vector<std::string> expected
+	{
+		"send 0", "sent 0", "send 1", "sent 1", "send 10", "send 20", "sent 10", "sent 20",
+	};
+
+	TEST_CHECK(context, log == expected);
+}
+
+int main(int argc, char ** argv)
+{
+	test_runner runner(argc, argv);
+
+	runner.run("values_arrive_in_order", test_values_arrive_in_order);
+	runner.run("many_hand_overs", test_many_hand_overs);
+	runner.run("wakes_receiver_before_sender_continues", test_wakes_receiver_before_sender_continues);
+	runner.run("senders_wake_in_order", test_senders_wake_in_order);
+
+	return runner.finish();
+}
@@ -0,0 +1,933 @@
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// Checks circular_deque against std::deque.
+
+// For std::size_t, std::ptrdiff_t
+#include <cstddef>
+
+// For std::deque
+#include <deque>
+
+// For std::vector
+#include <vector>
+
+// For std::string, std::to_string, std::stoi
+#include <string>
+
+// For std::equal, std::lower_bound, std::upper_bound, std::count_if, std::remove_if
+#include <algorithm>
+
+// For std::iterator_traits, std::distance, std::advance
+#include <iterator>
+
+// For std::true_type, std::is_same, std::is_convertible
+#include <type_traits>
+
+// For circular_deque
+#include "circular_deque.h"
+
+// For test_runner, test_context, test_random, counted
+#include "test.h"
+
+
+// counted holds no pointers into itself, so it can take the relocating paths
+template<>
+struct circular_deque_is_trivially_relocatable<counted> : std::true_type
+{
+};
+
+
+template<typename Deque, typename Reference>
+bool same_contents(const Deque & deque, const Reference & reference)
+{
+	if (deque.size() != reference.size())
+		return false;
+
+	for (std::size_t index = 0; index < reference.size(); ++index)
+		if (!(deque[index] == reference[index]))
+			return false;
+
+	return true;
+}
+
+// Regression: clear used to start from the free slot before the front
+// instead of the first object, destroying objects the array still owned
+void test_clear_releases_each_object_once(test_context & context)
+{
+	{
+		circular_deque<counted, 8> deque;
+
+		deque.push_back(counted(1));
+		deque.push_back(counted(2));
+		deque.push_front(counted(3));
+
+		deque.clear();
+
+		TEST_CHECK(context, deque.empty());
+		TEST_CHECK(context, counted::live == 0);
+	}
+
+	// Destroying the deque must not destroy anything a second time
+	TEST_CHECK(context, counted::live == 0);
+
+	{
+		circular_deque<std::string, 4> deque;
+
+		// Wrap the objects around the end of the array before clearing
+		for (int round = 0; round < 3; ++round)
+		{
+			deque.push_back(std::string(64, 'a'));
+			deque.push_back(std::string(64, 'b'));
+			deque.pop_front();
+		}
+
+		deque.clear();
+		deque.push_back("after");
+
+		TEST_CHECK(context, (deque.size() == 1) && (deque.front() == "after"));
+	}
+}
+
+// Regression: contains used to start from the free slot before the front,
+// so it found a stale value left there by a pop
+void test_contains_skips_free_slots(test_context & context)
+{
+	circular_deque<int, 8> deque;
+
+	deque.push_back(1);
+	deque.push_front(5);
+	deque.pop_front();
+
+	TEST_CHECK(context, deque.contains(1));
+	TEST_CHECK(context, !deque.contains(5));
+
+	// And again with the objects wrapped around the end of the array
+	circular_deque<int, 4> wrapped;
+
+	for (int value = 0; value < 6; ++value)
+	{
+		wrapped.push_back(value);
+
+		if (wrapped.full())
+			wrapped.pop_front();
+	}
+
+	for (int value = 0; value < 6; ++value)
+		TEST_CHECK(context, wrapped.contains(value) == (value >= 3));
+}
+
+// Regression: the pops used to destroy the free slot past the end they popped from,
+// leaving the popped object alive and destroying a slot the array still owned
+void test_pops_release_the_popped_object(test_context & context)
+{
+	{
+		circular_deque<counted, 8> deque;
+
+		deque.push_back(counted(1));
+		deque.push_back(counted(2));
+		deque.push_front(counted(3));
+		deque.push_front(counted(4));
+
+		deque.pop_back();
+		TEST_CHECK(context, counted::live == 3);
+		TEST_CHECK(context, deque.back().value() == 1);
+
+		deque.pop_front();
+		TEST_CHECK(context, counted::live == 2);
+		TEST_CHECK(context, deque.front().value() == 3);
+
+		deque.pop_back(2);
+		TEST_CHECK(context, counted::live == 0);
+		TEST_CHECK(context, deque.empty());
+	}
+
+	TEST_CHECK(context, counted::live == 0);
+
+	{
+		circular_deque<std::string, 4> deque;
+
+		for (int round = 0; round < 10; ++round)
+		{
+			deque.push_back(std::string(64, 'x'));
+			deque.push_front(std::string(64, 'y'));
+			deque.pop_back();
+			deque.pop_front();
+		}
+
+		TEST_CHECK(context, deque.empty());
+	}
+}
+
+template<typename Type, std::size_t capacity, typename Make>
+void check_linearize(test_context & context, Make make)
+{
+	test_random random(capacity);
+
+	for (std::size_t round = 0; round < 200; ++round)
+	{
+		circular_deque<Type, capacity> deque;
+		std::deque<Type> reference;
+
+		// Wander the front around the array, then fill to a random size
+		const std::size_t shift = random.below(capacity * 2);
+		const std::size_t size = random.below(capacity + 1);
+
+		for (std::size_t index = 0; index < shift; ++index)
+		{
+			deque.push_back(make(0));
+			deque.pop_front();
+		}
+
+		for (std::size_t index = 0; index < size; ++index)
+		{
+			const int value = static_cast<int>(index + 1);
+
+			if (random.below(2) == 0)
+			{
+				deque.push_back(make(value));
+				reference.push_back(make(value));
+			}
+			else
+			{
+				deque.push_front(make(value));
+				reference.push_front(make(value));
+			}
+		}
+
+		const auto span = deque.linearize();
+
+		TEST_CHECK(context, span.size() == reference.size());
+		TEST_CHECK(context, std::equal(span.begin(), span.end(), reference.begin(), reference.end()));
+		TEST_CHECK(context, same_contents(deque, reference));
+
+		// The deque must carry on working from its new indices
+		if (!deque.full())
+		{
+			deque.push_back(make(-1));
+			reference.push_back(make(-1));
+		}
+
+		if (!deque.full())
+		{
+			deque.push_front(make(-2));
+			reference.push_front(make(-2));
+		}
+
+		if (!TEST_CHECK(context, same_contents(deque, reference)))
+			return;
+	}
+}
+
+void test_linearize_matches_std_deque(test_context & context)
+{
+	const auto make_int = [](int value) { return value; };
+	const auto make_string = [](int value) { return std::to_string(value) + std::string(32, '.'); };
+	const auto make_counted = [](int value) { return counted(value); };
+
+	// Odd, power of two, and larger than the relocation buffer
+	check_linearize<int, 7>(context, make_int);
+	check_linearize<int, 8>(context, make_int);
+	check_linearize<int, 100>(context, make_int);
+	check_linearize<std::string, 7>(context, make_string);
+	check_linearize<std::string, 16>(context, make_string);
+	check_linearize<counted, 9>(context, make_counted);
+	check_linearize<counted, 100>(context, make_counted);
+
+	TEST_CHECK(context, counted::live == 0);
+}
+
+// Counts every move, to tell how much of the array an operation touches
+struct move_counted
+{
+	static inline std::size_t moves = 0;
+
+	int value = 0;
+
+	move_counted() = default;
+
+	move_counted(int value) :
+		value { value }
+	{
+	}
+
+	move_counted(const move_counted & other) = default;
+	move_counted & operator =(const move_counted & other) = default;
+
+	move_counted(move_counted && other) :
+		value { other.value }
+	{
+		++moves;
+	}
+
+	move_counted & operator =(move_counted && other)
+	{
+		this->value = other.value;
+		++moves;
+		return *this;
+	}
+};
+
+// Linearizing moves the objects, not the whole array
+void test_linearize_cost_follows_size(test_context & context)
+{
+	constexpr std::size_t capacity = 4096;
+
+	circular_deque<move_counted, capacity> deque;
+
+	// Walk the front to the last slot of the array
+	for (std::size_t index = 0; index < ((capacity / 2) - 1); ++index)
+	{
+		deque.push_back(move_counted(0));
+		deque.pop_front();
+	}
+
+	// So these two wrap around its end
+	deque.push_back(move_counted(1));
+	deque.push_back(move_counted(2));
+	deque.push_front(move_counted(3));
+
+	move_counted::moves = 0;
+
+	const auto span = deque.linearize();
+
+	TEST_CHECK(context, span.size() == 3);
+	TEST_CHECK(context, (span[0].value == 3) && (span[1].value == 1) && (span[2].value == 2));
+
+	// A few moves per object, rather than a few per slot
+	TEST_CHECK(context, move_counted::moves <= 12);
+
+	// And the deque carries on from its new indices
+	deque.push_front(move_counted(4));
+	deque.push_back(move_counted(5));
+
+	TEST_CHECK(context, (deque.front().value == 4) && (deque.back().value == 5) && (deque.size() == 5));
+}
+
+// const_iterator used to be built on circular_deque<const Type>, so it didn't compile
+void test_const_iteration(test_context & context)
+{
+	circular_deque<int, 5> deque;
+	std::deque<int> reference;
+
+	// Wrap the objects around the end of the array
+	for (int value = 0; value < 12; ++value)
+	{
+		deque.push_back(value);
+		reference.push_back(value);
+
+		if (deque.full())
+		{
+			deque.pop_front();
+			reference.pop_front();
+		}
+	}
+
+	const auto & constant = deque;
+
+	TEST_CHECK(context, std::equal(constant.begin(), constant.end(), reference.begin(), reference.end()));
+	TEST_CHECK(context, std::equal(constant.rbegin(), constant.rend(), reference.rbegin(), reference.rend()));
+	TEST_CHECK(context, std::equal(deque.cbegin(), deque.cend(), reference.cbegin(), reference.cend()));
+
+	// An iterator converts to a const_iterator
+	circular_deque<int, 5>::const_iterator position = deque.begin();
+	TEST_CHECK(context, position == constant.begin());
+	TEST_CHECK(context, *++position == reference[1]);
+
+	static_assert(std::is_same<std::iterator_traits<circular_deque<int, 5>::const_iterator>::value_type, int>::value, "The value type of a const_iterator should be the deque's");
+	static_assert(std::is_same<std::iterator_traits<circular_deque<int, 5>::const_iterator>::reference, const int &>::value, "A const_iterator should only give const access");
+	static_assert(!std::is_convertible<circular_deque<int, 5>::const_iterator, circular_deque<int, 5>::iterator>::value, "A const_iterator mustn't convert to an iterator");
+}
+
+template<std::size_t capacity>
+void check_binary_search(test_context & context)
+{
+	test_random random(capacity + 1);
+
+	for (std::size_t round = 0; round < 300; ++round)
+	{
+		circular_deque<int, capacity> deque;
+		std::vector<int> reference;
+
+		// Wander the front around the array so the objects often wrap
+		const std::size_t shift = random.below(capacity * 2);
+
+		for (std::size_t index = 0; index < shift; ++index)
+		{
+			deque.push_back(0);
+			deque.pop_front();
+		}
+
+		// Sorted, with duplicates
+		const std::size_t size = random.below(capacity + 1);
+		int value = 0;
+
+		for (std::size_t index = 0; index < size; ++index)
+		{
+			value += static_cast<int>(random.below(3));
+			deque.push_back(value);
+			reference.push_back(value);
+		}
+
+		const auto & constant = deque;
+
+		for (int key = -1; key <= (value + 1); ++key)
+		{
+			const auto lower = static_cast<std::ptrdiff_t>(std::lower_bound(reference.begin(), reference.end(), key) - reference.begin());
+			const auto upper = static_cast<std::ptrdiff_t>(std::upper_bound(reference.begin(), reference.end(), key) - reference.begin());
+
+			TEST_CHECK(context, std::distance(deque.begin(), deque.lower_bound(key)) == lower);
+			TEST_CHECK(context, std::distance(deque.begin(), deque.upper_bound(key)) == upper);
+			TEST_CHECK(context, std::distance(constant.begin(), constant.lower_bound(key)) == lower);
+			TEST_CHECK(context, std::distance(constant.begin(), constant.upper_bound(key)) == upper);
+
+			const auto range = constant.equal_range(key);
+
+			TEST_CHECK(context, std::distance(constant.begin(), range.first) == lower);
+			TEST_CHECK(context, std::distance(constant.begin(), range.second) == upper);
+
+			// The end iterator must compare equal to end()
+			if (lower == static_cast<std::ptrdiff_t>(reference.size()))
+				TEST_CHECK(context, constant.lower_bound(key) == constant.end());
+		}
+
+		// And with a comparison, keyed on half of each element
+		const auto halves = [](int element, int key) { return (element / 2) < key; };
+
+		for (int key = -1; key <= ((value / 2) + 1); ++key)
+		{
+			const auto lower = static_cast<std::ptrdiff_t>(std::lower_bound(reference.begin(), reference.end(), key, halves) - reference.begin());
+			TEST_CHECK(context, std::distance(constant.begin(), constant.lower_bound(key, halves)) == lower);
+		}
+	}
+}
+
+void test_binary_search_matches_std_lower_bound(test_context & context)
+{
+	check_binary_search<2>(context);
+	check_binary_search<7>(context);
+	check_binary_search<16>(context);
+}
+
+template<typename Type, std::size_t capacity, typename Make>
+void check_insert_erase(test_context & context, Make make)
+{
+	test_random random(capacity + 2);
+
+	circular_deque<Type, capacity> deque;
+	std::deque<Type> reference;
+
+	for (int step = 0; step < 4000; ++step)
+	{
+		const std::size_t offset = random.below(deque.size() + 1);
+		const std::size_t room = (deque.max_size() - deque.size());
+		const int value = (step + 1);
+
+		auto position = deque.begin();
+		std::advance(position, static_cast<std::ptrdiff_t>(offset));
+
+		const auto reference_position = (reference.begin() + static_cast<std::ptrdiff_t>(offset));
+
+		switch (random.below(5))
+		{
+			case 0:
+				if (room > 0)
+				{
+					const Type object = make(value);
+					const auto result = deque.insert(position, object);
+					reference.insert(reference_position, object);
+					TEST_CHECK(context, std::distance(deque.begin(), result) == static_cast<std::ptrdiff_t>(offset));
+				}
+				break;
+
+			case 1:
+			{
+				const std::size_t amount = random.below(room + 1);
+				deque.insert(position, amount, make(value));
+
+				// Some versions of libstdc++ corrupt a std::deque inserting nothing in the middle
+				if (amount > 0)
+					reference.insert(reference_position, amount, make(value));
+				break;
+			}
+
+			case 2:
+			{
+				std::vector<Type> objects;
+
+				for (std::size_t index = random.below(room + 1); index > 0; --index)
+					objects.push_back(make(value + static_cast<int>(index)));
+
+				deque.insert(position, objects.begin(), objects.end());
+
+				// As above
+				if (!objects.empty())
+					reference.insert(reference_position, objects.begin(), objects.end());
+				break;
+			}
+
+			case 3:
+				if (offset < deque.size())
+				{
+					const auto result = deque.erase(position);
+					reference.erase(reference_position);
+					TEST_CHECK(context, std::distance(deque.begin(), result) == static_cast<std::ptrdiff_t>(offset));
+				}
+				break;
+
+			case 4:
+			{
+				const std::size_t amount = random.below(deque.size() - offset + 1);
+
+				auto last = position;
+				std::advance(last, static_cast<std::ptrdiff_t>(amount));
+
+				deque.erase(position, last);
+				reference.erase(reference_position, (reference_position + static_cast<std::ptrdiff_t>(amount)));
+				break;
+			}
+		}
+
+		if (!TEST_CHECK(context, same_contents(deque, reference)))
+			return;
+	}
+}
+
+void test_insert_erase_match_std_deque(test_context & context)
+{
+	const auto make_int = [](int value) { return value; };
+	const auto make_string = [](int value) { return std::to_string(value) + std::string(32, '.'); };
+	const auto make_counted = [](int value) { return counted(value); };
+
+	// Odd, power of two, and larger than the relocation buffer
+	check_insert_erase<int, 7>(context, make_int);
+	check_insert_erase<int, 8>(context, make_int);
+	check_insert_erase<int, 100>(context, make_int);
+	check_insert_erase<std::string, 9>(context, make_string);
+	check_insert_erase<counted, 8>(context, make_counted);
+	check_insert_erase<counted, 100>(context, make_counted);
+
+	TEST_CHECK(context, counted::live == 0);
+}
+
+template<typename Type, std::size_t capacity, typename Make, typename Value>
+void check_erase_if(test_context & context, Make make, Value value_of)
+{
+	test_random random(capacity + 3);
+
+	for (std::size_t round = 0; round < 300; ++round)
+	{
+		circular_deque<Type, capacity> deque;
+		std::vector<Type> reference;
+
+		// Wander the front around the array so the objects often wrap
+		const std::size_t shift = random.below(capacity * 2);
+
+		for (std::size_t index = 0; index < shift; ++index)
+		{
+			deque.push_back(make(1));
+			deque.pop_front();
+		}
+
+		for (std::size_t index = random.below(capacity + 1); index > 0; --index)
+		{
+			const int value = static_cast<int>(random.below(100) + 1);
+			deque.push_back(make(value));
+			reference.push_back(make(value));
+		}
+
+		// Remove none, all, or some of the objects
+		const int divisor = static_cast<int>(random.below(4) + 1);
+		const auto predicate = [&](const Type & object) { return (value_of(object) % divisor) == 0; };
+
+		const std::size_t expected = static_cast<std::size_t>(std::count_if(reference.begin(), reference.end(), predicate));
+		reference.erase(std::remove_if(reference.begin(), reference.end(), predicate), reference.end());
+
+		TEST_CHECK(context, erase_if(deque, predicate) == expected);
+
+		if (!TEST_CHECK(context, same_contents(deque, reference)))
+			return;
+	}
+}
+
+void test_erase_if_matches_std_remove_if(test_context & context)
+{
+	const auto make_int = [](int value) { return value; };
+	const auto make_string = [](int value) { return std::to_string(value); };
+	const auto make_counted = [](int value) { return counted(value); };
+
+	const auto int_value = [](int value) { return value; };
+	const auto string_value = [](const std::string & value) { return std::stoi(value); };
+	const auto counted_value = [](const counted & value) { return value.value(); };
+
+	check_erase_if<int, 7>(context, make_int, int_value);
+	check_erase_if<int, 16>(context, make_int, int_value);
+	check_erase_if<std::string, 9>(context, make_string, string_value);
+	check_erase_if<counted, 8>(context, make_counted, counted_value);
+
+	TEST_CHECK(context, counted::live == 0);
+}
+
+template<typename Type, std::size_t capacity, typename Make>
+void check_reserve_commit(test_context & context, Make make)
+{
+	test_random random(capacity + 5);
+
+	std::size_t wrapped = 0;
+
+	for (std::size_t round = 0; round < 300; ++round)
+	{
+		circular_deque<Type, capacity> deque;
+		std::deque<Type> reference;
+
+		// Wander the front around the array, then fill to a random size, sometimes empty or full
+		const std::size_t shift = random.below(capacity * 2);
+
+		for (std::size_t index = 0; index < shift; ++index)
+		{
+			deque.push_back(make(1));
+			deque.pop_front();
+		}
+
+		for (std::size_t index = random.below(capacity + 1); index > 0; --index)
+		{
+			const int value = static_cast<int>(random.below(100) + 1);
+			deque.push_back(make(value));
+			reference.push_back(make(value));
+		}
+
+		// Ask for more than fits now and then
+		const std::size_t amount = random.below(capacity + 3);
+		const std::size_t expected = std::min(amount, (capacity - reference.size()));
+
+		const auto slots = deque.reserve_back(amount);
+
+		TEST_CHECK(context, slots.size() == expected);
+		TEST_CHECK(context, slots.first.empty() ? slots.second.empty() : true);
+
+		if (!slots.second.empty())
+			++wrapped;
+
+		// Fill every reserved slot, then commit anything from none to all of them
+		std::vector<Type *> addresses;
+
+		for (auto & slot : slots.first)
+			addresses.push_back(&slot);
+
+		for (auto & slot : slots.second)
+			addresses.push_back(&slot);
+
+		for (std::size_t index = 0; index < addresses.size(); ++index)
+			*addresses[index] = make(static_cast<int>(index + 200));
+
+		const std::size_t committed = random.below(expected + 1);
+		const std::size_t old_size = reference.size();
+
+		deque.commit_back(committed);
+
+		for (std::size_t index = 0; index < committed; ++index)
+			reference.push_back(make(static_cast<int>(index + 200)));
+
+		if (!TEST_CHECK(context, same_contents(deque, reference)))
+			return;
+
+		// The reserved slots are the ones the committed objects now occupy
+		for (std::size_t index = 0; index < committed; ++index)
+			TEST_CHECK(context, &deque[old_size + index] == addresses[index]);
+
+		// The deque must carry on working from its new back index
+		if (!deque.full())
+		{
+			deque.push_back(make(-1));
+			reference.push_back(make(-1));
+		}
+
+		if (!deque.empty())
+		{
+			deque.pop_front();
+			reference.pop_front();
+		}
+
+		if (!TEST_CHECK(context, same_contents(deque, reference)))
+			return;
+	}
+
+	// Some reservations must have been split where they wrap
+	TEST_CHECK(context, wrapped > 0);
+}
+
+void test_reserve_commit_matches_std_deque(test_context & context)
+{
+	const auto make_int = [](int value) { return value; };
+	const auto make_string = [](int value) { return std::to_string(value) + std::string(32, '.'); };
+
+	check_reserve_commit<int, 7>(context, make_int);
+	check_reserve_commit<int, 8>(context, make_int);
+	check_reserve_commit<std::string, 9>(context, make_string);
+}
+
+void test_reserve_commit_statistics(test_context & context)
+{
+	circular_deque<int, 4, circular_deque_statistics> deque;
+
+	const auto slots = deque.reserve_back(3);
+	TEST_CHECK(context, slots.size() == 3);
+
+	slots.first[0] = 1;
+	slots.first[1] = 2;
+
+	// Only the first two are committed
+	deque.commit_back(2);
+
+	// Committing nothing changes nothing
+	deque.commit_back(0);
+
+	const auto & statistics = deque.statistics();
+
+	TEST_CHECK(context, deque.size() == 2);
+	TEST_CHECK(context, statistics.back_push_count() == 2);
+	TEST_CHECK(context, statistics.high_water_mark() == 2);
+	TEST_CHECK(context, statistics.full_count() == 0);
+
+	// Only two slots are left
+	const auto rest = deque.reserve_back(5);
+	TEST_CHECK(context, rest.size() == 2);
+
+	deque.commit_back(2);
+
+	TEST_CHECK(context, deque.full());
+	TEST_CHECK(context, statistics.back_push_count() == 4);
+	TEST_CHECK(context, statistics.high_water_mark() == 4);
+	TEST_CHECK(context, statistics.full_count() == 1);
+
+	// Full, so nothing can be reserved
+	TEST_CHECK(context, deque.reserve_back(1).empty());
+
+	deque.commit_back(0);
+	TEST_CHECK(context, statistics.full_count() == 1);
+}
+
+template<typename Type, std::size_t capacity, typename Make>
+void check_peek_consume(test_context & context, Make make)
+{
+	test_random random(capacity + 7);
+
+	std::size_t wrapped = 0;
+
+	for (std::size_t round = 0; round < 300; ++round)
+	{
+		circular_deque<Type, capacity> deque;
+		std::deque<Type> reference;
+
+		// Wander the front around the array so the objects often wrap
+		const std::size_t shift = random.below(capacity * 2);
+
+		for (std::size_t index = 0; index < shift; ++index)
+		{
+			deque.push_back(make(1));
+			deque.pop_front();
+		}
+
+		for (std::size_t index = random.below(capacity + 1); index > 0; --index)
+		{
+			const int value = static_cast<int>(random.below(100) + 1);
+			deque.push_back(make(value));
+			reference.push_back(make(value));
+		}
+
+		// Ask for more than there is now and then
+		const std::size_t amount = random.below(capacity + 3);
+		const std::size_t expected = std::min(amount, reference.size());
+
+		const auto runs = deque.peek_front(amount);
+		const auto const_runs = static_cast<const circular_deque<Type, capacity> &>(deque).peek_front(amount);
+
+		TEST_CHECK(context, runs.size() == expected);
+		TEST_CHECK(context, runs.first.empty() ? runs.second.empty() : true);
+		TEST_CHECK(context, const_runs.first.data() == runs.first.data());
+		TEST_CHECK(context, const_runs.first.size() == runs.first.size());
+		TEST_CHECK(context, const_runs.second.data() == runs.second.data());
+		TEST_CHECK(context, const_runs.second.size() == runs.second.size());
+
+		if (!runs.second.empty())
+			++wrapped;
+
+		// The runs hold the front objects in order, in place
+		std::vector<Type> peeked(runs.first.begin(), runs.first.end());
+		peeked.insert(peeked.end(), runs.second.begin(), runs.second.end());
+
+		TEST_CHECK(context, std::equal(peeked.begin(), peeked.end(), reference.begin(), (reference.begin() + expected)));
+
+		for (std::size_t index = 0; index < runs.first.size(); ++index)
+			TEST_CHECK(context, &runs.first[index] == &deque[index]);
+
+		for (std::size_t index = 0; index < runs.second.size(); ++index)
+			TEST_CHECK(context, &runs.second[index] == &deque[runs.first.size() + index]);
+
+		// Consume anything from none to all of the peeked objects
+		const std::size_t consumed = random.below(expected + 1);
+
+		deque.consume_front(consumed);
+		reference.erase(reference.begin(), (reference.begin() + consumed));
+
+		if (!TEST_CHECK(context, same_contents(deque, reference)))
+			return;
+	}
+
+	// Some runs must have been split where they wrap
+	TEST_CHECK(context, wrapped > 0);
+}
+
+void test_peek_consume_matches_std_deque(test_context & context)
+{
+	const auto make_int = [](int value) { return value; };
+	const auto make_counted = [](int value) { return counted(value); };
+
+	check_peek_consume<int, 7>(context, make_int);
+	check_peek_consume<int, 8>(context, make_int);
+	check_peek_consume<counted, 9>(context, make_counted);
+
+	TEST_CHECK(context, counted::live == 0);
+}
+
+// Consuming objects releases them, even though peeking handed out references
+void test_consume_releases_the_consumed_objects(test_context & context)
+{
+	{
+		circular_deque<counted, 4> deque;
+
+		// Wrap the objects around the end of the array
+		for (int value = 1; value <= 6; ++value)
+		{
+			if (deque.full())
+				deque.pop_front();
+
+			deque.push_back(counted(value));
+		}
+
+		TEST_CHECK(context, counted::live == 4);
+
+		const auto runs = deque.peek_front(3);
+		TEST_CHECK(context, runs.size() == 3);
+		TEST_CHECK(context, runs.first[0].value() == 3);
+
+		deque.consume_front(runs.size());
+
+		TEST_CHECK(context, counted::live == 1);
+		TEST_CHECK(context, deque.front().value() == 6);
+
+		deque.consume_front(0);
+		TEST_CHECK(context, counted::live == 1);
+	}
+
+	TEST_CHECK(context, counted::live == 0);
+}
+
+void test_statistics(test_context & context)
+{
+	circular_deque<int, 4, circular_deque_statistics> deque;
+
+	deque.push_back(1);
+	deque.push_front(2);
+	TEST_CHECK(context, deque.try_push_back(3));
+	TEST_CHECK(context, deque.try_push_front(4));
+
+	// Full, so these are turned away
+	TEST_CHECK(context, !deque.try_push_back(5));
+	TEST_CHECK(context, !deque.try_push_front(6));
+	TEST_CHECK(context, deque.size() == 4);
+
+	deque.pop_back();
+	deque.pop_front(3);
+
+	const auto & statistics = deque.statistics();
+
+	TEST_CHECK(context, statistics.back_push_count() == 2);
+	TEST_CHECK(context, statistics.front_push_count() == 2);
+	TEST_CHECK(context, statistics.back_pop_count() == 1);
+	TEST_CHECK(context, statistics.front_pop_count() == 3);
+	TEST_CHECK(context, statistics.high_water_mark() == 4);
+	TEST_CHECK(context, statistics.full_count() == 1);
+	TEST_CHECK(context, statistics.empty_count() == 1);
+	TEST_CHECK(context, statistics.rejected_push_count() == 2);
+
+	// Without statistics, the deque is no bigger than before
+	static_assert(sizeof(circular_deque<int, 4>) == ((3 * sizeof(std::size_t)) + (4 * sizeof(int))), "The default statistics policy should take up no space");
+}
+
+// Pushes and pops at random against std::deque
+void test_push_pop_matches_std_deque(test_context & context)
+{
+	test_random random;
+
+	circular_deque<int, 7> deque;
+	std::deque<int> reference;
+
+	for (int step = 0; step < 10000; ++step)
+	{
+		const std::size_t operation = random.below(4);
+		const int value = static_cast<int>(random.below(1000));
+
+		if ((operation == 0) && !deque.full())
+		{
+			deque.push_back(value);
+			reference.push_back(value);
+		}
+		else if ((operation == 1) && !deque.full())
+		{
+			deque.push_front(value);
+			reference.push_front(value);
+		}
+		else if ((operation == 2) && !deque.empty())
+		{
+			deque.pop_back();
+			reference.pop_back();
+		}
+		else if ((operation == 3) && !deque.empty())
+		{
+			deque.pop_front();
+			reference.pop_front();
+		}
+
+		if (!TEST_CHECK(context, same_contents(deque, reference)))
+			return;
+
+		TEST_CHECK(context, std::equal(deque.begin(), deque.end(), reference.begin(), reference.end()));
+	}
+}
+
+int main(int argc, char ** argv)
+{
+	test_runner runner(argc, argv);
+
+	runner.run("clear_releases_each_object_once", test_clear_releases_each_object_once);
+	runner.run("contains_skips_free_slots", test_contains_skips_free_slots);
+	runner.run("pops_release_the_popped_object", test_pops_release_the_popped_object);
+	runner.run("push_pop_matches_std_deque", test_push_pop_matches_std_deque);
+	runner.run("linearize_matches_std_deque", test_linearize_matches_std_deque);
+	runner.run("linearize_cost_follows_size", test_linearize_cost_follows_size);
+	runner.run("const_iteration", test_const_iteration);
+	runner.run("binary_search_matches_std_lower_bound", test_binary_search_matches_std_lower_bound);
+	runner.run("insert_erase_match_std_deque", test_insert_erase_match_std_deque);
+	runner.run("erase_if_matches_std_remove_if", test_erase_if_matches_std_remove_if);
+	runner.run("reserve_commit_matches_std_deque", test_reserve_commit_matches_std_deque);
+	runner.run("reserve_commit_statistics", test_reserve_commit_statistics);
+	runner.run("peek_consume_matches_std_deque", test_peek_consume_matches_std_deque);
+	runner.run("consume_releases_the_consumed_objects", test_consume_releases_the_consumed_objects);
+	runner.run("statistics", test_statistics);
+
+	return runner.finish();
+}
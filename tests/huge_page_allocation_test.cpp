@@ -0,0 +1,97 @@
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// Checks that huge_page_capacity sizes deques to fit their huge pages,
+// and that make_huge_page_unique hands out enough memory for them.
+
+// For std::size_t
+#include <cstddef>
+
+// For std::uintptr_t
+#include <cstdint>
+
+// For huge_page_capacity, huge_page_overhead, fits_huge_pages, make_huge_page_unique
+#include "huge_page_allocation.h"
+
+// For circular_deque
+#include "circular_deque.h"
+
+// For blocking_circular_deque
+#include "blocking_circular_deque.h"
+
+// For test_runner, test_context
+#include "test.h"
+
+
+struct packet
+{
+	unsigned char bytes[96];
+};
+
+constexpr std::size_t ring_overhead = huge_page_overhead<circular_deque<packet, 2>>();
+using ring = circular_deque<packet, huge_page_capacity<packet>(100000, ring_overhead)>;
+
+static_assert(ring::capacity >= 100000, "huge_page_capacity rounded down");
+static_assert(fits_huge_pages<ring>(), "A circular_deque spills onto another huge page");
+
+// A mutex and two wait strategies take more room than a plain deque's indices
+constexpr std::size_t blocking_overhead = huge_page_overhead<blocking_circular_deque<std::uint64_t, 2>>();
+using blocking_ring = blocking_circular_deque<std::uint64_t, huge_page_capacity<std::uint64_t>(262144, blocking_overhead)>;
+
+static_assert(blocking_overhead > huge_page_overhead<circular_deque<std::uint64_t, 2>>(), "blocking_circular_deque has no members of its own");
+static_assert(fits_huge_pages<blocking_ring>(), "A blocking_circular_deque spills onto another huge page");
+
+// Filling the huge pages with the buffer alone leaves no room for the other members
+static_assert(!fits_huge_pages<blocking_circular_deque<std::uint64_t, 262144>>(), "fits_huge_pages ignores the other members");
+
+
+void test_capacity_fills_the_pages(test_context & context)
+{
+	const std::size_t pages = ((sizeof(ring) + huge_page_size - 1) / huge_page_size);
+
+	// One more element would spill onto another huge page
+	TEST_CHECK(context, (((ring::capacity + 1) * sizeof(packet)) + ring_overhead) > (pages * huge_page_size));
+
+	// The smallest request still gets a whole huge page's worth
+	TEST_CHECK(context, ((huge_page_capacity<packet>(1, ring_overhead) * sizeof(packet)) + ring_overhead) <= huge_page_size);
+	TEST_CHECK(context, ((huge_page_capacity<packet>(1, ring_overhead) + 1) * sizeof(packet) + ring_overhead) > huge_page_size);
+}
+
+void test_allocates_whole_pages(test_context & context)
+{
+	auto deque = make_huge_page_unique<blocking_ring>();
+
+	TEST_CHECK(context, deque->empty());
+
+	for (std::uint64_t value = 0; value < blocking_ring::capacity; ++value)
+		TEST_CHECK(context, deque->try_push(value));
+
+	TEST_CHECK(context, deque->full());
+
+	// Only huge page backings promise huge page alignment
+	if (deque.get_deleter().backing() != huge_page_backing::normal_pages)
+		TEST_CHECK(context, (reinterpret_cast<std::uintptr_t>(deque.get()) % huge_page_size) == 0);
+}
+
+int main(int argc, char ** argv)
+{
+	test_runner runner(argc, argv);
+
+	runner.run("capacity_fills_the_pages", test_capacity_fills_the_pages);
+	runner.run("allocates_whole_pages", test_allocates_whole_pages);
+
+	return runner.finish();
+}
@@ -0,0 +1,208 @@
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+
+// Checks latency_histogram's percentiles against a sorted std::vector,
+// within the error its bucket layout promises.
+
+// For std::size_t
+#include <cstddef>
+
+// For std::uint64_t
+#include <cstdint>
+
+// For std::vector
+#include <vector>
+
+// For std::sort
+#include <algorithm>
+
+// For std::numeric_limits
+#include <limits>
+
+// For latency_histogram
+#include "latency_histogram.h"
+
+// For test_runner, test_context, test_random
+#include "test.h"
+
+
+constexpr std::uint64_t largest = std::numeric_limits<std::uint64_t>::max();
+
+// Whether reported is a fair report of value: no lower,
+// and no more than 1 part in 2^(precision_bits - 1) higher
+template<std::size_t precision_bits>
+bool within_error(std::uint64_t value, std::uint64_t reported)
+{
+	return (reported >= value) && ((reported - value) <= (value >> (precision_bits - 1)));
+}
+
+// Values at the edges of the exactly counted range, of each power of two, and of the top bucket
+template<std::size_t precision_bits>
+std::vector<std::uint64_t> edge_values()
+{
+	constexpr std::uint64_t linear_count = (std::uint64_t(1) << precision_bits);
+
+	std::vector<std::uint64_t> values { 0, 1, (linear_count - 1), linear_count, (linear_count + 1), (largest - 1), largest };
+
+	for (std::size_t bit = precision_bits; bit < 64; ++bit)
+	{
+		const std::uint64_t power = (std::uint64_t(1) << bit);
+
+		values.push_back(power - 1);
+		values.push_back(power);
+		values.push_back(power + 1);
+	}
+
+	return values;
+}
+
+// Each value is reported on its own, without being clamped to the maximum
+template<std::size_t precision_bits>
+void check_single_values(test_context & context)
+{
+	for (const std::uint64_t value : edge_values<precision_bits>())
+	{
+		latency_histogram<precision_bits> histogram;
+
+		histogram.record(value);
+		histogram.record(largest);
+
+		// The lower of the two is the 50th percentile
+		const std::uint64_t reported = histogram.value_at_percentile(50.0);
+
+		if (!TEST_CHECK(context, within_error<precision_bits>(value, reported)))
+			return;
+
+		// Values counted exactly are reported exactly
+		if (value < (std::uint64_t(1) << precision_bits))
+			TEST_CHECK(context, reported == value);
+	}
+
+	// The top bucket ends at the largest value, rather than overflowing to zero
+	latency_histogram<precision_bits> histogram;
+
+	histogram.record(largest - 1);
+	histogram.record(largest);
+
+	TEST_CHECK(context, histogram.value_at_percentile(50.0) == largest);
+	TEST_CHECK(context, histogram.value_at_percentile(0.0) == largest);
+}
+
+void test_single_values(test_context & context)
+{
+	check_single_values<2>(context);
+	check_single_values<3>(context);
+	check_single_values<7>(context);
+	check_single_values<10>(context);
+}
+
+template<std::size_t precision_bits>
+void check_percentiles(test_context & context)
+{
+	test_random random(precision_bits);
+
+	const double percentiles[] { 0.0, 1.0, 10.0, 25.0, 50.0, 75.0, 90.0, 99.0, 99.9, 100.0 };
+
+	for (std::size_t round = 0; round < 50; ++round)
+	{
+		latency_histogram<precision_bits> histogram;
+		std::vector<std::uint64_t> values;
+
+		// Mostly random values of every magnitude, with some of the edges mixed in
+		const std::vector<std::uint64_t> edges = edge_values<precision_bits>();
+		const std::size_t size = (random.below(1000) + 1);
+
+		for (std::size_t index = 0; index < size; ++index)
+		{
+			const std::uint64_t value = (random.below(8) == 0) ? edges[random.below(edges.size())] : (random.next() >> random.below(64));
+
+			histogram.record(value);
+			values.push_back(value);
+		}
+
+		std::sort(values.begin(), values.end());
+
+		TEST_CHECK(context, histogram.count() == values.size());
+		TEST_CHECK(context, histogram.min() == values.front());
+		TEST_CHECK(context, histogram.max() == values.back());
+
+		for (const double percentile : percentiles)
+		{
+			// The nearest rank, counting from one
+			std::size_t rank = static_cast<std::size_t>(((percentile / 100.0) * static_cast<double>(values.size())) + 0.5);
+
+			if (rank < 1)
+				rank = 1;
+
+			const std::uint64_t expected = values[rank - 1];
+			const std::uint64_t reported = histogram.value_at_percentile(percentile);
+
+			if (!TEST_CHECK(context, within_error<precision_bits>(expected, reported)))
+				return;
+
+			// Never past the largest value recorded
+			TEST_CHECK(context, reported <= values.back());
+		}
+
+		TEST_CHECK(context, histogram.value_at_percentile(100.0) == values.back());
+	}
+}
+
+void test_percentiles_match_sorted_values(test_context & context)
+{
+	check_percentiles<2>(context);
+	check_percentiles<3>(context);
+	check_percentiles<7>(context);
+	check_percentiles<10>(context);
+}
+
+void test_merge_and_clear(test_context & context)
+{
+	latency_histogram<> first;
+	latency_histogram<> second;
+
+	first.record(10);
+	first.record(20);
+	second.record(5);
+	second.record(1000);
+
+	first.merge(second);
+
+	TEST_CHECK(context, first.count() == 4);
+	TEST_CHECK(context, first.min() == 5);
+	TEST_CHECK(context, first.max() == 1000);
+	TEST_CHECK(context, first.mean() == 258.75);
+	TEST_CHECK(context, first.value_at_percentile(50.0) == 10);
+
+	first.clear();
+
+	TEST_CHECK(context, first.empty());
+	TEST_CHECK(context, first.min() == 0);
+	TEST_CHECK(context, first.max() == 0);
+	TEST_CHECK(context, first.value_at_percentile(50.0) == 0);
+}
+
+int main(int argc, char ** argv)
+{
+	test_runner runner(argc, argv);
+
+	runner.run("single_values", test_single_values);
+	runner.run("percentiles_match_sorted_values", test_percentiles_match_sorted_values);
+	runner.run("merge_and_clear", test_merge_and_clear);
+
+	return runner.finish();
+}
@@ -0,0 +1,92 @@
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// Checks numa_allocation.h on whatever nodes this machine has.
+// A single node machine, or a sandbox without the NUMA system calls,
+// can't show pages landing on different nodes, so these only check consistency.
+
+// For std::size_t
+#include <cstddef>
+
+// For std::memset
+#include <cstring>
+
+// For numa_allocate, numa_deallocate, numa_node_of, make_numa_unique
+#include "numa_allocation.h"
+
+// For circular_deque
+#include "circular_deque.h"
+
+// For test_runner, test_context
+#include "test.h"
+
+
+void test_untouched_pages_are_nowhere(test_context & context)
+{
+	const std::size_t size = (std::size_t(1) << 20);
+	void * memory = numa_allocate(size, 0);
+
+	TEST_CHECK(context, memory != nullptr);
+	TEST_CHECK(context, numa_node_of(memory, size) == numa_any_node);
+	TEST_CHECK(context, numa_node_of(memory, 0) == numa_any_node);
+
+	numa_deallocate(memory, size);
+}
+
+void test_every_page_agrees_with_the_first(test_context & context)
+{
+	const std::size_t size = (std::size_t(1) << 20);
+	char * memory = static_cast<char *>(numa_allocate(size, 0));
+
+	// Only touches the first half, the rest is skipped
+	std::memset(memory, 1, (size / 2));
+
+	const int first = numa_node_of(memory);
+	const int all = numa_node_of(memory, size);
+
+	TEST_CHECK(context, (all == first) || (all == numa_any_node));
+	TEST_CHECK(context, all != numa_mixed_nodes);
+
+	// A range that doesn't start or end on a page boundary
+	std::memset(memory, 1, size);
+	TEST_CHECK(context, numa_node_of((memory + 10), (size - 20)) == all);
+
+	numa_deallocate(memory, size);
+}
+
+void test_places_a_deque(test_context & context)
+{
+	using deque = circular_deque<int, 4096>;
+
+	auto placed = make_numa_unique<deque>(0);
+
+	for (int value = 0; value < 4096; ++value)
+		placed->push_back(value);
+
+	TEST_CHECK(context, placed->size() == 4096);
+	TEST_CHECK(context, numa_node_of(placed.get(), sizeof(deque)) != numa_mixed_nodes);
+}
+
+int main(int argc, char ** argv)
+{
+	test_runner runner(argc, argv);
+
+	runner.run("untouched_pages_are_nowhere", test_untouched_pages_are_nowhere);
+	runner.run("every_page_agrees_with_the_first", test_every_page_agrees_with_the_first);
+	runner.run("places_a_deque", test_places_a_deque);
+
+	return runner.finish();
+}
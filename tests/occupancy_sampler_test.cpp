@@ -0,0 +1,177 @@
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// Checks occupancy_sampler's sources and its CSV and Chrome trace output.
+
+// For std::size_t
+#include <cstddef>
+
+// For std::ostringstream
+#include <sstream>
+
+// For std::string
+#include <string>
+
+// For std::thread
+#include <thread>
+
+// For std::atomic
+#include <atomic>
+
+// For occupancy_sampler, circular_deque_published_statistics
+#include "occupancy_sampler.h"
+
+// For blocking_circular_deque
+#include "blocking_circular_deque.h"
+
+// For test_runner, test_context
+#include "test.h"
+
+
+void test_samples_owned_deques(test_context & context)
+{
+	circular_deque<int, 8, circular_deque_statistics> owned;
+	circular_deque<int, 8, circular_deque_published_statistics> published;
+
+	occupancy_sampler<2, 8> sampler;
+
+	const auto owned_index = sampler.add("owned", owned);
+	const auto published_index = sampler.add("published", published);
+
+	owned.push_back(1);
+	owned.push_back(2);
+	owned.pop_front();
+
+	published.push_back(1);
+	published.push_front(2);
+	published.push_back(3);
+	published.clear();
+
+	sampler.sample_all();
+
+	TEST_CHECK(context, sampler.size() == 2);
+
+	TEST_CHECK(context, sampler[0].source == owned_index);
+	TEST_CHECK(context, (sampler[0].size == 1) && (sampler[0].pushes == 2) && (sampler[0].pops == 1));
+
+	TEST_CHECK(context, sampler[1].source == published_index);
+	TEST_CHECK(context, (sampler[1].size == 0) && (sampler[1].pushes == 3) && (sampler[1].pops == 3));
+}
+
+// A monitoring thread samples a blocking deque while two other threads use it
+void test_samples_across_threads(test_context & context)
+{
+	constexpr int count = 20000;
+
+	blocking_circular_deque<int, 64, yield_wait_strategy, circular_deque_published_statistics> deque;
+	occupancy_sampler<1, 256> sampler;
+
+	sampler.add("pipeline", deque);
+
+	std::atomic<bool> done { false };
+
+	std::thread monitor([&]()
+	{
+		while (!done.load())
+		{
+			sampler.sample_all();
+			std::this_thread::yield();
+		}
+	});
+
+	std::thread producer([&]()
+	{
+		for (int value = 0; value < count; ++value)
+			deque.push(value);
+	});
+
+	long long sum = 0;
+
+	for (int value = 0; value < count; ++value)
+		sum += deque.pop();
+
+	producer.join();
+	done.store(true);
+	monitor.join();
+
+	TEST_CHECK(context, sum == ((static_cast<long long>(count) * (count - 1)) / 2));
+
+	for (std::size_t index = 0; index < sampler.size(); ++index)
+	{
+		TEST_CHECK(context, sampler[index].size <= 64);
+		TEST_CHECK(context, sampler[index].pops <= sampler[index].pushes);
+	}
+
+	TEST_CHECK(context, deque.published_statistics().push_count() == count);
+	TEST_CHECK(context, deque.published_statistics().pop_count() == count);
+}
+
+void test_csv_quotes_names(test_context & context)
+{
+	circular_deque<int, 4, circular_deque_statistics> plain;
+	circular_deque<int, 4, circular_deque_statistics> comma;
+	circular_deque<int, 4, circular_deque_statistics> quote;
+	circular_deque<int, 4, circular_deque_statistics> control;
+
+	occupancy_sampler<4, 4, steady_clock_source> sampler;
+
+	sampler.add("plain", plain);
+	sampler.add("stage 1, parse", comma);
+	sampler.add("the \"fast\" one\\", quote);
+	sampler.add("stage\n1\t\x01", control);
+
+	sampler.sample_one(0, 10);
+	sampler.sample_one(1, 20);
+	sampler.sample_one(2, 30);
+	sampler.sample_one(3, 40);
+
+	std::ostringstream csv;
+	sampler.write_csv(csv);
+
+	const std::string expected_csv =
+		"timestamp,deque,size,pushes,pops\n"
+		"10,plain,0,0,0\n"
+		"20,\"stage 1, parse\",0,0,0\n"
+		"30,\"the \"\"fast\"\" one\\\",0,0,0\n"
+		"40,\"stage\n1\t\x01\",0,0,0\n";
+
+	TEST_CHECK(context, csv.str() == expected_csv);
+
+	// JSON strings can't hold control characters, so they are escaped too
+	std::ostringstream json;
+	sampler.write_chrome_trace(json);
+
+	const std::string expected_json =
+		"{\"traceEvents\":["
+		"\n{\"name\":\"plain\",\"ph\":\"C\",\"pid\":0,\"tid\":0,\"ts\":0.010,\"args\":{\"size\":0,\"pushes\":0,\"pops\":0}},"
+		"\n{\"name\":\"stage 1, parse\",\"ph\":\"C\",\"pid\":0,\"tid\":1,\"ts\":0.020,\"args\":{\"size\":0,\"pushes\":0,\"pops\":0}},"
+		"\n{\"name\":\"the \\\"fast\\\" one\\\\\",\"ph\":\"C\",\"pid\":0,\"tid\":2,\"ts\":0.030,\"args\":{\"size\":0,\"pushes\":0,\"pops\":0}},"
+		"\n{\"name\":\"stage\\n1\\t\\u0001\",\"ph\":\"C\",\"pid\":0,\"tid\":3,\"ts\":0.040,\"args\":{\"size\":0,\"pushes\":0,\"pops\":0}}"
+		"\n]}\n";
+
+	TEST_CHECK(context, json.str() == expected_json);
+}
+
+int main(int argc, char ** argv)
+{
+	test_runner runner(argc, argv);
+
+	runner.run("samples_owned_deques", test_samples_owned_deques);
+	runner.run("samples_across_threads", test_samples_across_threads);
+	runner.run("csv_quotes_names", test_csv_quotes_names);
+
+	return runner.finish();
+}
@@ -0,0 +1,285 @@
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+
+// Checks that operation traces read back exactly as they were recorded,
+// and that damaged traces are rejected or cut short.
+
+// For std::size_t
+#include <cstddef>
+
+// For std::uint64_t
+#include <cstdint>
+
+// For std::vector
+#include <vector>
+
+// For std::string
+#include <string>
+
+// For std::stringstream
+#include <sstream>
+
+// For std::numeric_limits
+#include <limits>
+
+// For recording_circular_deque, operation_trace_writer, operation_trace_reader
+#include "operation_trace.h"
+
+// For test_runner, test_context, test_random
+#include "test.h"
+
+
+struct manual_clock
+{
+	using tick_type = std::uint64_t;
+
+	static inline tick_type ticks = 0;
+
+	static tick_type now()
+	{
+		return ticks;
+	}
+};
+
+bool same_record(const trace_record & left, const trace_record & right)
+{
+	return (left.operation == right.operation) && (left.delta == right.delta) && (left.size == right.size);
+}
+
+// Reads every record after the header
+std::vector<trace_record> read_all(operation_trace_reader & reader)
+{
+	std::vector<trace_record> records;
+	trace_record record {};
+
+	while (reader.read(record))
+		records.push_back(record);
+
+	return records;
+}
+
+// Records random operations, many blocks' worth, and reads them back
+void test_recording_round_trip(test_context & context)
+{
+	test_random random;
+
+	std::stringstream stream;
+	std::vector<trace_record> expected;
+
+	{
+		manual_clock::ticks = 0;
+
+		recording_circular_deque<int, 8, manual_clock> deque(stream);
+
+		for (int step = 0; step < 20000; ++step)
+		{
+			// Mostly small steps, but sometimes one needing a ten byte varint
+			const std::uint64_t delta = (random.below(100) == 0) ? (std::numeric_limits<std::uint64_t>::max() >> random.below(8)) : random.below(300);
+
+			// The clock can't pass its largest value, so start over instead
+			if (delta > (std::numeric_limits<std::uint64_t>::max() - manual_clock::ticks))
+			{
+				manual_clock::ticks = 0;
+				deque.clear();
+				expected.push_back(trace_record { trace_operation::clear, 0, 0 });
+				continue;
+			}
+
+			manual_clock::ticks += delta;
+
+			const std::size_t operation = random.below(4);
+			trace_operation recorded = trace_operation::push_back;
+
+			if ((operation == 0) && !deque.full())
+				deque.push_back(step);
+			else if ((operation == 1) && !deque.full())
+			{
+				deque.push_front(step);
+				recorded = trace_operation::push_front;
+			}
+			else if ((operation == 2) && !deque.empty())
+			{
+				deque.pop_back();
+				recorded = trace_operation::pop_back;
+			}
+			else if ((operation == 3) && !deque.empty())
+			{
+				deque.pop_front();
+				recorded = trace_operation::pop_front;
+			}
+			else
+			{
+				deque.clear();
+				recorded = trace_operation::clear;
+			}
+
+			expected.push_back(trace_record { recorded, delta, deque.size() });
+		}
+	}
+
+	// Well past the 4 KiB block
+	TEST_CHECK(context, stream.str().size() > (4 * 4096));
+
+	operation_trace_reader reader(stream);
+
+	TEST_CHECK(context, reader.good());
+	TEST_CHECK(context, reader.header().element_size == sizeof(int));
+	TEST_CHECK(context, reader.header().capacity == 8);
+
+	const std::vector<trace_record> records = read_all(reader);
+
+	if (!TEST_CHECK(context, records.size() == expected.size()))
+		return;
+
+	for (std::size_t index = 0; index < records.size(); ++index)
+		if (!TEST_CHECK(context, same_record(records[index], expected[index])))
+			return;
+}
+
+// Varints at each length from one byte to ten
+void test_varint_lengths(test_context & context)
+{
+	std::vector<trace_record> expected;
+
+	for (unsigned bit = 0; bit < 64; ++bit)
+	{
+		const std::uint64_t power = (std::uint64_t(1) << bit);
+
+		expected.push_back(trace_record { trace_operation::push_back, (power - 1), power });
+		expected.push_back(trace_record { trace_operation::pop_front, power, (power + 1) });
+	}
+
+	expected.push_back(trace_record { trace_operation::clear, std::numeric_limits<std::uint64_t>::max(), std::numeric_limits<std::uint64_t>::max() });
+
+	std::stringstream stream;
+
+	{
+		operation_trace_writer writer(stream, trace_header { std::numeric_limits<std::uint64_t>::max(), 0 });
+
+		for (const trace_record & record : expected)
+			writer.write(record);
+	}
+
+	operation_trace_reader reader(stream);
+
+	TEST_CHECK(context, reader.good());
+	TEST_CHECK(context, reader.header().element_size == std::numeric_limits<std::uint64_t>::max());
+	TEST_CHECK(context, reader.header().capacity == 0);
+
+	const std::vector<trace_record> records = read_all(reader);
+
+	if (!TEST_CHECK(context, records.size() == expected.size()))
+		return;
+
+	for (std::size_t index = 0; index < records.size(); ++index)
+		TEST_CHECK(context, same_record(records[index], expected[index]));
+}
+
+// A trace of three records, the last needing several bytes
+std::string small_trace()
+{
+	std::stringstream stream;
+
+	{
+		operation_trace_writer writer(stream, trace_header { 4, 16 });
+
+		writer.write(trace_record { trace_operation::push_back, 1, 1 });
+		writer.write(trace_record { trace_operation::push_front, 2, 2 });
+		writer.write(trace_record { trace_operation::pop_back, 100000, 1 });
+	}
+
+	return stream.str();
+}
+
+void test_damaged_traces(test_context & context)
+{
+	const std::string trace = small_trace();
+
+	// The untouched trace reads back in full
+	{
+		std::istringstream stream(trace);
+		operation_trace_reader reader(stream);
+
+		TEST_CHECK(context, reader.good());
+		TEST_CHECK(context, read_all(reader).size() == 3);
+	}
+
+	// Wrong magic
+	{
+		std::string damaged = trace;
+		damaged[0] = 'X';
+
+		std::istringstream stream(damaged);
+		operation_trace_reader reader(stream);
+
+		TEST_CHECK(context, !reader.good());
+		TEST_CHECK(context, read_all(reader).empty());
+	}
+
+	// Unknown version
+	{
+		std::string damaged = trace;
+		damaged[4] = static_cast<char>(operation_trace_writer::version + 1);
+
+		std::istringstream stream(damaged);
+		operation_trace_reader reader(stream);
+
+		TEST_CHECK(context, !reader.good());
+	}
+
+	// Cut off inside the header, or before it
+	for (std::size_t length = 0; length < 7; ++length)
+	{
+		std::istringstream stream(trace.substr(0, length));
+		operation_trace_reader reader(stream);
+
+		TEST_CHECK(context, !reader.good());
+	}
+
+	// Cut off inside the last record: only the whole records are read
+	for (std::size_t cut = 1; cut < 5; ++cut)
+	{
+		std::istringstream stream(trace.substr(0, (trace.size() - cut)));
+		operation_trace_reader reader(stream);
+
+		TEST_CHECK(context, reader.good());
+		TEST_CHECK(context, read_all(reader).size() == 2);
+	}
+
+	// An operation that doesn't exist ends the trace
+	{
+		std::string damaged = trace;
+		damaged[7] = static_cast<char>(0x7F);
+
+		std::istringstream stream(damaged);
+		operation_trace_reader reader(stream);
+
+		TEST_CHECK(context, reader.good());
+		TEST_CHECK(context, read_all(reader).empty());
+	}
+}
+
+int main(int argc, char ** argv)
+{
+	test_runner runner(argc, argv);
+
+	runner.run("recording_round_trip", test_recording_round_trip);
+	runner.run("varint_lengths", test_varint_lengths);
+	runner.run("damaged_traces", test_damaged_traces);
+
+	return runner.finish();
+}
@@ -0,0 +1,76 @@
+#!/bin/sh
+
+#
+#  Copyright (C) 2020 Pharap (@Pharap)
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#       http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+#
+
+# Builds and runs every test program, failing if any of them fails.
+# The tests are built with assertions enabled and, by default,
+# with the address and undefined behaviour sanitizers.
+#
+# Usage, from the repository root:
+#   tests/run_tests.sh [compiler] [extra flags...]
+# Pass -fno-sanitize=all as an extra flag for compilers without the sanitizers.
+
+set -eu
+
+compiler="${1:-${CXX:-c++}}"
+[ "$#" -gt 0 ] && shift
+
+directory="$(cd "$(dirname "$0")" && pwd)"
+output="$(mktemp -d "${TMPDIR:-/tmp}/circular_deque_tests.XXXXXX")"
+trap 'rm -rf "$output"' EXIT
+
+failed=0
+
+# Builds and runs one test program with the given language standard
+run_test()
+{
+	name="$1"
+	standard="$2"
+	shift 2
+
+	echo "== $name"
+
+	if ! "$compiler" -std="$standard" -O1 -g -Wall -Wextra -fsanitize=address,undefined -pthread -I"$directory/.." -I"$directory" "$directory/$name.cpp" -o "$output/$name" "$@"
+	then
+		failed=1
+		return
+	fi
+
+	if ! "$output/$name"
+	then
+		failed=1
+	fi
+}
+
+run_test circular_deque_test c++17 "$@"
+run_test soa_circular_deque_test c++17 "$@"
+run_test circular_bit_deque_test c++17 "$@"
+run_test sliding_window_extrema_test c++17 "$@"
+run_test sliding_window_statistics_test c++17 "$@"
+run_test sliding_window_aggregate_test c++17 "$@"
+run_test timed_window_test c++17 "$@"
+run_test latency_histogram_test c++17 "$@"
+run_test traced_circular_deque_test c++17 "$@"
+run_test operation_trace_test c++17 "$@"
+run_test benchmark_baseline_test c++17 "$@"
+run_test blocking_circular_deque_test c++17 "$@"
+run_test occupancy_sampler_test c++17 "$@"
+run_test numa_allocation_test c++17 "$@"
+run_test huge_page_allocation_test c++17 "$@"
+run_test circular_deque_channel_test c++20 "$@"
+
+exit "$failed"
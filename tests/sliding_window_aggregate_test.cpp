@@ -0,0 +1,162 @@
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// Checks sliding_window_aggregate against folding a std::deque holding the same window.
+
+// For std::size_t
+#include <cstddef>
+
+// For std::deque
+#include <deque>
+
+// For std::string
+#include <string>
+
+// For sliding_window_aggregate
+#include "sliding_window_aggregate.h"
+
+// For test_runner, test_context, test_random
+#include "test.h"
+
+
+// Associative but not commutative, so any reordering of the fold shows up
+struct concatenate
+{
+	std::string operator ()(const std::string & left, const std::string & right) const
+	{
+		return (left + right);
+	}
+};
+
+// The largest value, and the oldest position it was seen at
+struct indexed_maximum
+{
+	int value = -1;
+	int index = -1;
+
+	bool operator ==(const indexed_maximum & other) const
+	{
+		return (this->value == other.value) && (this->index == other.index);
+	}
+};
+
+struct keep_oldest_maximum
+{
+	indexed_maximum operator ()(const indexed_maximum & left, const indexed_maximum & right) const
+	{
+		return (right.value > left.value) ? right : left;
+	}
+};
+
+template<typename Window, typename Reference, typename Operation>
+bool same_fold(const Window & window, const Reference & reference, typename Window::value_type identity, Operation operation)
+{
+	if (window.size() != reference.size())
+		return false;
+
+	for (const auto & value : reference)
+		identity = operation(identity, value);
+
+	return (window.query() == identity);
+}
+
+void test_concatenation_matches_fold(test_context & context)
+{
+	test_random random;
+
+	sliding_window_aggregate<std::string, 12, concatenate> window(std::string {});
+	std::deque<std::string> reference;
+
+	for (int step = 0; step < 20000; ++step)
+	{
+		if (!window.full() && (window.empty() || (random.below(3) != 0)))
+		{
+			const std::string value(1, static_cast<char>('a' + random.below(26)));
+
+			window.push(value);
+			reference.push_back(value);
+		}
+		else
+		{
+			window.expire();
+			reference.pop_front();
+		}
+
+		if (!TEST_CHECK(context, same_fold(window, reference, std::string {}, concatenate {})))
+			return;
+	}
+}
+
+void test_indexed_maximum_matches_fold(test_context & context)
+{
+	test_random random;
+
+	sliding_window_aggregate<indexed_maximum, 16, keep_oldest_maximum> window(indexed_maximum {});
+	std::deque<indexed_maximum> reference;
+
+	for (int step = 0; step < 20000; ++step)
+	{
+		if (!window.full() && (window.empty() || (random.below(2) != 0)))
+		{
+			// Few distinct values, so ties decide which index is kept
+			const indexed_maximum value { static_cast<int>(random.below(8)), step };
+
+			window.push(value);
+			reference.push_back(value);
+		}
+		else
+		{
+			window.expire();
+			reference.pop_front();
+		}
+
+		if (!TEST_CHECK(context, same_fold(window, reference, indexed_maximum {}, keep_oldest_maximum {})))
+			return;
+	}
+}
+
+void test_empty_window_yields_identity(test_context & context)
+{
+	sliding_window_aggregate<std::string, 4, concatenate> window(std::string {});
+
+	TEST_CHECK(context, window.query().empty());
+
+	window.push("a");
+	window.push("b");
+	window.expire();
+
+	TEST_CHECK(context, window.query() == "b");
+
+	window.expire();
+
+	TEST_CHECK(context, window.query().empty());
+
+	window.push("c");
+	window.clear();
+
+	TEST_CHECK(context, window.empty() && window.query().empty());
+}
+
+int main(int argc, char ** argv)
+{
+	test_runner runner(argc, argv);
+
+	runner.run("concatenation_matches_fold", test_concatenation_matches_fold);
+	runner.run("indexed_maximum_matches_fold", test_indexed_maximum_matches_fold);
+	runner.run("empty_window_yields_identity", test_empty_window_yields_identity);
+
+	return runner.finish();
+}
@@ -0,0 +1,122 @@
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// Checks sliding_window_extrema against a scan of a std::deque holding the same window.
+
+// For std::size_t
+#include <cstddef>
+
+// For std::deque
+#include <deque>
+
+// For std::min_element, std::max_element
+#include <algorithm>
+
+// For std::greater
+#include <functional>
+
+// For sliding_window_extrema
+#include "sliding_window_extrema.h"
+
+// For test_runner, test_context, test_random
+#include "test.h"
+
+
+template<typename Compare>
+void check_matches_scan(test_context & context, std::size_t value_range)
+{
+	test_random random;
+
+	sliding_window_extrema<int, 16, Compare> window;
+	std::deque<int> reference;
+
+	const Compare compare {};
+
+	for (int step = 0; step < 20000; ++step)
+	{
+		// Push more often than expire, so the window spends time full
+		if (!window.full() && (window.empty() || (random.below(3) != 0)))
+		{
+			const int value = static_cast<int>(random.below(value_range));
+
+			window.push(value);
+			reference.push_back(value);
+		}
+		else
+		{
+			window.expire();
+			reference.pop_front();
+		}
+
+		if (!TEST_CHECK(context, window.size() == reference.size()))
+			return;
+
+		if (reference.empty())
+			continue;
+
+		TEST_CHECK(context, window.min() == *std::min_element(reference.begin(), reference.end(), compare));
+		TEST_CHECK(context, window.max() == *std::max_element(reference.begin(), reference.end(), compare));
+	}
+}
+
+void test_matches_scan(test_context & context)
+{
+	check_matches_scan<std::less<int>>(context, 1000);
+}
+
+// Few distinct values, so equal values are often in the window together
+void test_matches_scan_with_duplicates(test_context & context)
+{
+	check_matches_scan<std::less<int>>(context, 4);
+}
+
+void test_matches_scan_with_reversed_order(test_context & context)
+{
+	check_matches_scan<std::greater<int>>(context, 1000);
+}
+
+void test_clear_starts_afresh(test_context & context)
+{
+	sliding_window_extrema<int, 4> window;
+
+	window.push(5);
+	window.push(1);
+	window.expire();
+	window.clear();
+
+	TEST_CHECK(context, window.empty());
+
+	window.push(3);
+	window.push(7);
+
+	TEST_CHECK(context, (window.min() == 3) && (window.max() == 7));
+
+	window.expire();
+
+	TEST_CHECK(context, (window.min() == 7) && (window.max() == 7));
+}
+
+int main(int argc, char ** argv)
+{
+	test_runner runner(argc, argv);
+
+	runner.run("matches_scan", test_matches_scan);
+	runner.run("matches_scan_with_duplicates", test_matches_scan_with_duplicates);
+	runner.run("matches_scan_with_reversed_order", test_matches_scan_with_reversed_order);
+	runner.run("clear_starts_afresh", test_clear_starts_afresh);
+
+	return runner.finish();
+}
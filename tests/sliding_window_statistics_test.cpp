@@ -0,0 +1,176 @@
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// Checks sliding_window_statistics against a two pass computation over the same window.
+
+// For std::size_t
+#include <cstddef>
+
+// For std::deque
+#include <deque>
+
+// For std::fabs
+#include <cmath>
+
+// For sliding_window_statistics
+#include "sliding_window_statistics.h"
+
+// For test_runner, test_context, test_random
+#include "test.h"
+
+
+// Whether actual is within tolerance of expected, relative to scale
+bool close_to(long double actual, long double expected, long double scale, long double tolerance = 1e-9L)
+{
+	return (std::fabs(actual - expected) <= (tolerance * ((scale > 1) ? scale : 1)));
+}
+
+struct window_summary
+{
+	long double sum = 0;
+	long double mean = 0;
+	long double squared_deviations = 0;
+};
+
+template<typename Type>
+window_summary summarise(const std::deque<Type> & values)
+{
+	window_summary result;
+
+	for (const Type & value : values)
+		result.sum += static_cast<long double>(value);
+
+	result.mean = (result.sum / static_cast<long double>(values.size()));
+
+	for (const Type & value : values)
+		result.squared_deviations += ((static_cast<long double>(value) - result.mean) * (static_cast<long double>(value) - result.mean));
+
+	return result;
+}
+
+template<typename Window, typename Type>
+bool same_statistics(const Window & window, const std::deque<Type> & reference, long double spread)
+{
+	if (window.size() != reference.size())
+		return false;
+
+	if (reference.empty())
+		return true;
+
+	const window_summary expected = summarise(reference);
+	const long double count = static_cast<long double>(reference.size());
+
+	if (!close_to(window.sum(), expected.sum, std::fabs(expected.sum)))
+		return false;
+
+	if (!close_to(window.mean(), expected.mean, std::fabs(expected.mean)))
+		return false;
+
+	// Deviations are on the scale of the spread of the values, not of the values themselves
+	if (!close_to(window.variance(), (expected.squared_deviations / count), (spread * spread), 1e-7L))
+		return false;
+
+	if ((reference.size() > 1) && !close_to(window.sample_variance(), (expected.squared_deviations / (count - 1)), (spread * spread), 1e-7L))
+		return false;
+
+	return true;
+}
+
+// Values of offset plus up to spread, pushed and expired at random
+template<typename Type>
+void check_matches_two_passes(test_context & context, double offset, double spread)
+{
+	test_random random;
+
+	sliding_window_statistics<Type, 32> window;
+	std::deque<Type> reference;
+
+	for (int step = 0; step < 50000; ++step)
+	{
+		if (!window.full() && (window.empty() || (random.below(3) != 0)))
+		{
+			const Type value = static_cast<Type>(offset + (spread * (static_cast<double>(random.below(1000001)) / 1000000.0)));
+
+			window.push(value);
+			reference.push_back(value);
+		}
+		else
+		{
+			window.expire();
+			reference.pop_front();
+		}
+
+		if (!TEST_CHECK(context, same_statistics(window, reference, spread)))
+			return;
+	}
+}
+
+void test_doubles_match_two_passes(test_context & context)
+{
+	check_matches_two_passes<double>(context, -50.0, 100.0);
+}
+
+// Large values with a small spread, where a naive sum of squares cancels
+void test_offset_values_match_two_passes(test_context & context)
+{
+	check_matches_two_passes<double>(context, 1.0e9, 1.0);
+}
+
+void test_integers_match_two_passes(test_context & context)
+{
+	check_matches_two_passes<long>(context, 1000000.0, 5000.0);
+}
+
+void test_recompute_and_clear(test_context & context)
+{
+	sliding_window_statistics<double, 8> window;
+	std::deque<double> reference;
+
+	for (double value : { 3.0, 1.0, 4.0, 1.0, 5.0, 9.0, 2.0, 6.0 })
+	{
+		window.push(value);
+		reference.push_back(value);
+	}
+
+	window.expire();
+	reference.pop_front();
+	window.recompute();
+
+	TEST_CHECK(context, same_statistics(window, reference, 10.0));
+	TEST_CHECK(context, close_to(window.mean(), (28.0L / 7.0L), 1));
+
+	window.clear();
+
+	TEST_CHECK(context, window.empty());
+	TEST_CHECK(context, window.sum() == 0);
+
+	window.push(2.0);
+	window.push(4.0);
+
+	TEST_CHECK(context, (window.mean() == 3.0) && (window.variance() == 1.0) && (window.sample_variance() == 2.0));
+}
+
+int main(int argc, char ** argv)
+{
+	test_runner runner(argc, argv);
+
+	runner.run("doubles_match_two_passes", test_doubles_match_two_passes);
+	runner.run("offset_values_match_two_passes", test_offset_values_match_two_passes);
+	runner.run("integers_match_two_passes", test_integers_match_two_passes);
+	runner.run("recompute_and_clear", test_recompute_and_clear);
+
+	return runner.finish();
+}
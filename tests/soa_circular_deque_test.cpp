@@ -0,0 +1,162 @@
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// Checks soa_circular_deque against a std::deque of tuples,
+// at capacities that wrap with a mask and with a comparison.
+
+// For std::size_t
+#include <cstddef>
+
+// For std::deque
+#include <deque>
+
+// For std::vector
+#include <vector>
+
+// For std::tuple, std::get, std::make_tuple
+#include <tuple>
+
+// For soa_circular_deque
+#include "soa_circular_deque.h"
+
+// For test_runner, test_context, test_random, counted
+#include "test.h"
+
+
+template<typename Deque, typename Reference>
+bool same_records(const Deque & deque, const Reference & reference)
+{
+	if (deque.size() != reference.size())
+		return false;
+
+	for (std::size_t index = 0; index < reference.size(); ++index)
+		if ((std::get<0>(deque[index]) != std::get<0>(reference[index])) || (std::get<1>(deque[index]) != std::get<1>(reference[index])))
+			return false;
+
+	return true;
+}
+
+// Both runs of a column, one after the other, hold that field of every record in order
+template<typename Deque, typename Reference>
+bool same_column(const Deque & deque, const Reference & reference)
+{
+	const auto spans = deque.template column<1>();
+
+	std::vector<double> joined;
+	joined.insert(joined.end(), spans.first.begin(), spans.first.end());
+	joined.insert(joined.end(), spans.second.begin(), spans.second.end());
+
+	if (joined.size() != reference.size())
+		return false;
+
+	for (std::size_t index = 0; index < reference.size(); ++index)
+		if (joined[index] != std::get<1>(reference[index]))
+			return false;
+
+	return true;
+}
+
+template<std::size_t capacity>
+void check_matches_std_deque(test_context & context)
+{
+	test_random random;
+
+	soa_circular_deque<capacity, int, double> deque;
+	std::deque<std::tuple<int, double>> reference;
+
+	for (int step = 0; step < 10000; ++step)
+	{
+		const std::size_t operation = random.below(5);
+		const int value = static_cast<int>(random.below(1000));
+		const auto record = std::make_tuple(value, (value * 0.5));
+
+		if ((operation == 0) && !deque.full())
+		{
+			deque.push_back(record);
+			reference.push_back(record);
+		}
+		else if ((operation == 1) && !deque.full())
+		{
+			deque.push_front(record);
+			reference.push_front(record);
+		}
+		else if ((operation == 2) && !deque.empty())
+		{
+			deque.pop_back();
+			reference.pop_back();
+		}
+		else if ((operation == 3) && !deque.empty())
+		{
+			deque.pop_front();
+			reference.pop_front();
+		}
+		else if ((operation == 4) && (random.below(50) == 0))
+		{
+			deque.clear();
+			reference.clear();
+		}
+
+		if (!TEST_CHECK(context, same_records(deque, reference) && same_column(deque, reference)))
+			return;
+	}
+}
+
+void test_mask_capacity_matches_std_deque(test_context & context)
+{
+	check_matches_std_deque<8>(context);
+}
+
+void test_comparison_capacity_matches_std_deque(test_context & context)
+{
+	check_matches_std_deque<7>(context);
+}
+
+void test_pops_release_each_field(test_context & context)
+{
+	{
+		soa_circular_deque<4, counted, counted> deque;
+
+		deque.push_back(std::make_tuple(counted(1), counted(2)));
+		deque.push_front(std::make_tuple(counted(3), counted(4)));
+		deque.push_back(std::make_tuple(counted(5), counted(6)));
+
+		TEST_CHECK(context, counted::live == 6);
+
+		deque.pop_front();
+		TEST_CHECK(context, counted::live == 4);
+
+		deque.pop_back();
+		TEST_CHECK(context, counted::live == 2);
+
+		deque.clear();
+		TEST_CHECK(context, counted::live == 0);
+
+		deque.push_back(std::make_tuple(counted(7), counted(8)));
+	}
+
+	TEST_CHECK(context, counted::live == 0);
+}
+
+int main(int argc, char ** argv)
+{
+	test_runner runner(argc, argv);
+
+	runner.run("mask_capacity_matches_std_deque", test_mask_capacity_matches_std_deque);
+	runner.run("comparison_capacity_matches_std_deque", test_comparison_capacity_matches_std_deque);
+	runner.run("pops_release_each_field", test_pops_release_each_field);
+
+	return runner.finish();
+}
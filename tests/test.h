@@ -0,0 +1,227 @@
+#pragma once
+
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// For std::size_t
+#include <cstddef>
+
+// For std::strstr
+#include <cstring>
+
+// For std::cout, std::cerr
+#include <iostream>
+
+// For std::uint64_t
+#include <cstdint>
+
+
+// A minimal, self-contained test harness.
+//
+// Each test is a function taking a test_context, which records failed checks
+// and carries on, so one run reports every failure rather than the first.
+// Every test program accepts --filter text to only run the tests whose name contains text,
+// and exits with a non-zero status if any check failed.
+
+class test_context
+{
+private:
+	const char * test_name;
+	std::size_t failure_count = 0;
+
+public:
+	explicit test_context(const char * name) :
+		test_name { name }
+	{
+	}
+
+	std::size_t failures() const
+	{
+		return this->failure_count;
+	}
+
+	// Prefer TEST_CHECK, which fills in the expression and location
+	bool check(bool condition, const char * expression, const char * file, int line)
+	{
+		if (!condition)
+		{
+			++this->failure_count;
+			std::cerr << file << ':' << line << ": " << this->test_name << ": check failed: " << expression << '\n';
+		}
+
+		return condition;
+	}
+};
+
+#define TEST_CHECK(context, condition) (context).check(static_cast<bool>(condition), #condition, __FILE__, __LINE__)
+
+class test_runner
+{
+private:
+	const char * filter = nullptr;
+	std::size_t run_count = 0;
+	std::size_t failed_count = 0;
+
+public:
+	test_runner(int argc, char ** argv)
+	{
+		for (int index = 1; index < argc; ++index)
+			if ((std::strcmp(argv[index], "--filter") == 0) && ((index + 1) < argc))
+				this->filter = argv[++index];
+	}
+
+	template<typename Test>
+	void run(const char * name, Test test)
+	{
+		if ((this->filter != nullptr) && (std::strstr(name, this->filter) == nullptr))
+			return;
+
+		test_context context(name);
+		test(context);
+
+		++this->run_count;
+
+		if (context.failures() > 0)
+		{
+			++this->failed_count;
+			std::cout << "FAIL " << name << '\n';
+		}
+		else
+		{
+			std::cout << "ok   " << name << '\n';
+		}
+	}
+
+	// Prints a summary and returns the exit status for main
+	int finish() const
+	{
+		std::cout << (this->run_count - this->failed_count) << " of " << this->run_count << " tests passed\n";
+
+		return (this->failed_count > 0) ? 1 : 0;
+	}
+};
+
+// A small, fast, reproducible pseudo random generator (xorshift64*)
+class test_random
+{
+private:
+	std::uint64_t state;
+
+public:
+	explicit test_random(std::uint64_t seed = 0x9E3779B97F4A7C15u) :
+		state { (seed != 0) ? seed : 1 }
+	{
+	}
+
+	std::uint64_t next()
+	{
+		this->state ^= (this->state >> 12);
+		this->state ^= (this->state << 25);
+		this->state ^= (this->state >> 27);
+		return (this->state * 0x2545F4914F6CDD1Du);
+	}
+
+	// A value in [0, bound)
+	std::size_t below(std::size_t bound)
+	{
+		return static_cast<std::size_t>(this->next() % bound);
+	}
+};
+
+// Counts the objects holding a non-zero value, so that tests can tell
+// whether a container released every object it removed exactly once.
+// Moved from objects are left holding zero.
+class counted
+{
+public:
+	static inline long live = 0;
+
+private:
+	int value_field = 0;
+
+public:
+	counted() = default;
+
+	counted(int value) :
+		value_field { value }
+	{
+		this->acquire();
+	}
+
+	counted(const counted & other) :
+		value_field { other.value_field }
+	{
+		this->acquire();
+	}
+
+	counted(counted && other) :
+		value_field { other.value_field }
+	{
+		other.value_field = 0;
+	}
+
+	counted & operator =(const counted & other)
+	{
+		if (this != &other)
+		{
+			this->release();
+			this->value_field = other.value_field;
+			this->acquire();
+		}
+
+		return *this;
+	}
+
+	counted & operator =(counted && other)
+	{
+		if (this != &other)
+		{
+			this->release();
+			this->value_field = other.value_field;
+			other.value_field = 0;
+		}
+
+		return *this;
+	}
+
+	~counted()
+	{
+		this->release();
+	}
+
+	int value() const
+	{
+		return this->value_field;
+	}
+
+	bool operator ==(const counted & other) const
+	{
+		return (this->value_field == other.value_field);
+	}
+
+private:
+	void acquire()
+	{
+		if (this->value_field != 0)
+			++live;
+	}
+
+	void release()
+	{
+		if (this->value_field != 0)
+			--live;
+	}
+};
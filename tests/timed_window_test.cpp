@@ -0,0 +1,127 @@
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// Checks timed_window against a std::deque expired one entry at a time.
+
+// For std::size_t
+#include <cstddef>
+
+// For std::deque
+#include <deque>
+
+// For timed_window
+#include "timed_window.h"
+
+// For test_runner, test_context, test_random, counted
+#include "test.h"
+
+
+struct stamped
+{
+	long timestamp;
+	int value;
+};
+
+template<typename Window>
+bool same_entries(const Window & window, const std::deque<stamped> & reference)
+{
+	if (window.size() != reference.size())
+		return false;
+
+	for (std::size_t index = 0; index < reference.size(); ++index)
+		if ((window[index].timestamp != reference[index].timestamp) || (window[index].value != reference[index].value))
+			return false;
+
+	return true;
+}
+
+void test_expire_before_matches_linear_expiry(test_context & context)
+{
+	test_random random;
+
+	timed_window<long, int, 24> window;
+	std::deque<stamped> reference;
+
+	long now = 0;
+
+	for (int step = 0; step < 20000; ++step)
+	{
+		if (!window.full() && (random.below(3) != 0))
+		{
+			// Often no time passes, so equal timestamps sit side by side
+			now += static_cast<long>(random.below(3));
+
+			const int value = static_cast<int>(random.below(1000));
+
+			window.push(now, value);
+			reference.push_back(stamped { now, value });
+		}
+		else
+		{
+			// Sometimes a cut before everything, sometimes after everything
+			const long cut = (now - 20 + static_cast<long>(random.below(25)));
+
+			std::size_t expected = 0;
+
+			while (!reference.empty() && (reference.front().timestamp < cut))
+			{
+				reference.pop_front();
+				++expected;
+			}
+
+			TEST_CHECK(context, window.expire_before(cut) == expected);
+		}
+
+		if (!TEST_CHECK(context, same_entries(window, reference)))
+			return;
+	}
+}
+
+void test_expiry_releases_values(test_context & context)
+{
+	{
+		timed_window<int, counted, 8> window;
+
+		for (int time = 1; time <= 6; ++time)
+			window.push(time, counted(time));
+
+		TEST_CHECK(context, counted::live == 6);
+
+		// Keeps the entries stamped 4 and later
+		TEST_CHECK(context, window.expire_before(4) == 3);
+		TEST_CHECK(context, counted::live == 3);
+		TEST_CHECK(context, (window.front().timestamp == 4) && (window.back().timestamp == 6));
+
+		TEST_CHECK(context, window.expire_before(4) == 0);
+
+		window.clear();
+		TEST_CHECK(context, window.empty() && (counted::live == 0));
+
+		window.push(10, counted(10));
+	}
+
+	TEST_CHECK(context, counted::live == 0);
+}
+
+int main(int argc, char ** argv)
+{
+	test_runner runner(argc, argv);
+
+	runner.run("expire_before_matches_linear_expiry", test_expire_before_matches_linear_expiry);
+	runner.run("expiry_releases_values", test_expiry_releases_values);
+
+	return runner.finish();
+}
@@ -0,0 +1,116 @@
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+
+// Checks that traced_circular_deque records how long each popped object waited,
+// using a clock the test moves by hand.
+
+// For std::uint64_t
+#include <cstdint>
+
+// For traced_circular_deque
+#include "traced_circular_deque.h"
+
+// For test_runner, test_context
+#include "test.h"
+
+
+struct manual_clock
+{
+	using tick_type = std::uint64_t;
+
+	static inline tick_type ticks = 0;
+
+	static tick_type now()
+	{
+		return ticks;
+	}
+};
+
+void test_pops_record_sojourn_times(test_context & context)
+{
+	traced_circular_deque<int, 8, manual_clock> deque;
+
+	manual_clock::ticks = 100;
+	deque.push_back(1);
+
+	manual_clock::ticks = 130;
+	deque.push_front(2);
+
+	manual_clock::ticks = 170;
+	deque.push_back(3);
+
+	// The back waited 30 ticks
+	manual_clock::ticks = 200;
+	deque.pop_back();
+
+	TEST_CHECK(context, deque.histogram().count() == 1);
+	TEST_CHECK(context, deque.histogram().max() == 30);
+
+	// The front waited 120 ticks
+	manual_clock::ticks = 250;
+	deque.pop_front();
+
+	TEST_CHECK(context, deque.histogram().count() == 2);
+	TEST_CHECK(context, deque.histogram().min() == 30);
+	TEST_CHECK(context, deque.histogram().max() == 120);
+
+	TEST_CHECK(context, deque.size() == 1);
+	TEST_CHECK(context, deque.front() == 1);
+
+	// A clock that went backwards counts as no wait at all
+	manual_clock::ticks = 50;
+	deque.pop_front();
+
+	TEST_CHECK(context, deque.histogram().count() == 3);
+	TEST_CHECK(context, deque.histogram().min() == 0);
+	TEST_CHECK(context, deque.empty());
+}
+
+void test_clear_records_nothing(test_context & context)
+{
+	traced_circular_deque<int, 4, manual_clock> deque;
+
+	manual_clock::ticks = 0;
+
+	deque.push_back(1);
+	deque.push_back(2);
+
+	manual_clock::ticks = 1000;
+	deque.clear();
+
+	TEST_CHECK(context, deque.empty());
+	TEST_CHECK(context, deque.histogram().empty());
+
+	// The deque and its histogram carry on as normal afterwards
+	deque.push_back(3);
+
+	manual_clock::ticks = 1010;
+	deque.pop_back();
+
+	TEST_CHECK(context, deque.histogram().count() == 1);
+	TEST_CHECK(context, deque.histogram().max() == 10);
+}
+
+int main(int argc, char ** argv)
+{
+	test_runner runner(argc, argv);
+
+	runner.run("pops_record_sojourn_times", test_pops_record_sojourn_times);
+	runner.run("clear_records_nothing", test_clear_records_nothing);
+
+	return runner.finish();
+}
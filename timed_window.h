@@ -0,0 +1,147 @@
+#pragma once
+
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// For std::size_t
+#include <cstddef>
+
+// For std::assert
+#include <cassert>
+
+// For circular_deque
+#include "circular_deque.h"
+
+
+template<typename Timestamp, typename Type>
+struct timed_window_entry
+{
+	Timestamp timestamp;
+	Type value;
+};
+
+
+// Holds up to capacity_value timestamped values, oldest first.
+//
+// Timestamps must be pushed in non-decreasing order,
+// which lets expire_before find its cut point with a binary search
+// and remove everything older in a single step.
+template<typename Timestamp, typename Type, std::size_t capacity_value>
+class timed_window
+{
+public:
+	using timestamp_type = Timestamp;
+	using value_type = timed_window_entry<Timestamp, Type>;
+	using size_type = std::size_t;
+	using reference = value_type &;
+	using const_reference = const value_type &;
+
+public:
+	static constexpr size_type capacity = capacity_value;
+
+private:
+	circular_deque<value_type, capacity_value> entries {};
+
+public:
+	constexpr timed_window() = default;
+
+	// O(1)
+	constexpr bool empty() const
+	{
+		return this->entries.empty();
+	}
+
+	// O(1)
+	constexpr bool full() const
+	{
+		return this->entries.full();
+	}
+
+	// O(1)
+	constexpr size_type size() const
+	{
+		return this->entries.size();
+	}
+
+	// O(1)
+	constexpr size_type max_size() const
+	{
+		return capacity;
+	}
+
+	// O(1)
+	// The oldest entry
+	constexpr const_reference front() const
+	{
+		return this->entries.front();
+	}
+
+	// O(1)
+	// The newest entry
+	constexpr const_reference back() const
+	{
+		return this->entries.back();
+	}
+
+	// O(1)
+	constexpr const_reference operator [](size_type offset) const
+	{
+		return this->entries[offset];
+	}
+
+	// O(1)
+	void push(const timestamp_type & timestamp, const Type & value)
+	{
+		// Ensure the window isn't full
+		assert(!this->full());
+
+		// Ensure time isn't going backwards
+		assert(this->empty() || !(timestamp < this->entries.back().timestamp));
+
+		this->entries.push_back(value_type { timestamp, value });
+	}
+
+	// O(log n) to search, O(k) to destroy the k expired entries
+	// Removes every entry older than timestamp,
+	// returning the number of entries removed
+	size_type expire_before(const timestamp_type & timestamp)
+	{
+		// Find the first entry that isn't older than timestamp
+		size_type lower = 0;
+		size_type upper = this->entries.size();
+
+		while (lower < upper)
+		{
+			const size_type middle = (lower + ((upper - lower) / 2));
+
+			if (this->entries[middle].timestamp < timestamp)
+				lower = (middle + 1);
+			else
+				upper = middle;
+		}
+
+		// Everything before it expires at once
+		this->entries.pop_front(lower);
+
+		return lower;
+	}
+
+	// O(n)
+	void clear()
+	{
+		this->entries.clear();
+	}
+};
@@ -0,0 +1,69 @@
+#pragma once
+
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// For std::uint64_t
+#include <cstdint>
+
+// For std::chrono::steady_clock, std::chrono::duration_cast
+#include <chrono>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+// For __rdtsc
+#include <intrin.h>
+#define CIRCULAR_DEQUE_HAS_TSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+// For __rdtsc
+#include <x86intrin.h>
+#define CIRCULAR_DEQUE_HAS_TSC 1
+#else
+#define CIRCULAR_DEQUE_HAS_TSC 0
+#endif
+
+
+// Clock sources for the tracing utilities.
+// Each provides a static now() returning a tick count,
+// only the difference between two ticks is meaningful.
+
+// Ticks are nanoseconds of std::chrono::steady_clock
+struct steady_clock_source
+{
+	using tick_type = std::uint64_t;
+
+	static tick_type now()
+	{
+		const auto time = std::chrono::steady_clock::now().time_since_epoch();
+		return static_cast<tick_type>(std::chrono::duration_cast<std::chrono::nanoseconds>(time).count());
+	}
+};
+
+#if CIRCULAR_DEQUE_HAS_TSC
+
+// Ticks are CPU timestamp counter cycles.
+// Cheaper to read than steady_clock,
+// but only comparable between cores with an invariant, synchronised TSC.
+struct tsc_clock_source
+{
+	using tick_type = std::uint64_t;
+
+	static tick_type now()
+	{
+		return static_cast<tick_type>(__rdtsc());
+	}
+};
+
+#endif
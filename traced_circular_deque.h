@@ -0,0 +1,200 @@
+#pragma once
+
+//
+//  Copyright (C) 2020 Pharap (@Pharap)
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// For std::size_t
+#include <cstddef>
+
+// For std::move
+#include <utility>
+
+// For std::assert
+#include <cassert>
+
+// For circular_deque, circular_deque_no_statistics
+#include "circular_deque.h"
+
+// For latency_histogram
+#include "latency_histogram.h"
+
+// For steady_clock_source
+#include "trace_clock.h"
+
+
+// A circular_deque that timestamps every object as it is pushed
+// and records how long it sat in the deque when it is popped.
+//
+// Clock is one of the clock sources from trace_clock.h,
+// so the histogram is in nanoseconds for steady_clock_source
+// and in cycles for tsc_clock_source.
+template<typename Type, std::size_t capacity_value, typename Clock = steady_clock_source, typename Statistics = circular_deque_no_statistics>
+class traced_circular_deque
+{
+public:
+	using value_type = Type;
+	using size_type = std::size_t;
+	using reference = value_type &;
+	using const_reference = const value_type &;
+	using clock_type = Clock;
+	using tick_type = typename clock_type::tick_type;
+	using histogram_type = latency_histogram<>;
+	using statistics_type = Statistics;
+
+public:
+	static constexpr size_type capacity = capacity_value;
+
+private:
+	struct entry
+	{
+		tick_type timestamp;
+		value_type value;
+	};
+
+private:
+	circular_deque<entry, capacity_value, Statistics> entries {};
+	histogram_type sojourn_histogram {};
+
+public:
+	constexpr traced_circular_deque() = default;
+
+	// O(1)
+	constexpr bool empty() const
+	{
+		return this->entries.empty();
+	}
+
+	// O(1)
+	constexpr bool full() const
+	{
+		return this->entries.full();
+	}
+
+	// O(1)
+	constexpr size_type size() const
+	{
+		return this->entries.size();
+	}
+
+	// O(1)
+	constexpr size_type max_size() const
+	{
+		return capacity;
+	}
+
+	// O(1)
+	constexpr const statistics_type & statistics() const
+	{
+		return this->entries.statistics();
+	}
+
+	// O(1)
+	// The time each popped object spent in the deque
+	constexpr const histogram_type & histogram() const
+	{
+		return this->sojourn_histogram;
+	}
+
+	// O(1)
+	histogram_type & histogram()
+	{
+		return this->sojourn_histogram;
+	}
+
+	// O(1)
+	reference back()
+	{
+		return this->entries.back().value;
+	}
+
+	// O(1)
+	constexpr const_reference back() const
+	{
+		return this->entries.back().value;
+	}
+
+	// O(1)
+	reference front()
+	{
+		return this->entries.front().value;
+	}
+
+	// O(1)
+	constexpr const_reference front() const
+	{
+		return this->entries.front().value;
+	}
+
+	// O(1)
+	void push_back(const value_type & value)
+	{
+		this->entries.push_back(entry { clock_type::now(), value });
+	}
+
+	// O(1)
+	void push_back(value_type && value)
+	{
+		this->entries.push_back(entry { clock_type::now(), std::move(value) });
+	}
+
+	// O(1)
+	void push_front(const value_type & value)
+	{
+		this->entries.push_front(entry { clock_type::now(), value });
+	}
+
+	// O(1)
+	void push_front(value_type && value)
+	{
+		this->entries.push_front(entry { clock_type::now(), std::move(value) });
+	}
+
+	// O(1)
+	void pop_back()
+	{
+		// Ensure the deque isn't empty
+		assert(!this->empty());
+
+		this->record(this->entries.back().timestamp);
+		this->entries.pop_back();
+	}
+
+	// O(1)
+	void pop_front()
+	{
+		// Ensure the deque isn't empty
+		assert(!this->empty());
+
+		this->record(this->entries.front().timestamp);
+		this->entries.pop_front();
+	}
+
+	// O(n)
+	// Objects removed by clear are not recorded
+	void clear()
+	{
+		this->entries.clear();
+	}
+
+private:
+	void record(tick_type timestamp)
+	{
+		const tick_type now = clock_type::now();
+
+		// Guard against clocks that aren't synchronised between cores
+		this->sojourn_histogram.record((now > timestamp) ? (now - timestamp) : 0);
+	}
+};